@@ -0,0 +1,135 @@
+#include "bitmap.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WORD_BITS 64
+
+static inline size_t words_for(size_t bits) {
+    return (bits + WORD_BITS - 1) / WORD_BITS;
+}
+
+static inline uint64_t* leaf_word(const bitmap_t* bm, size_t word) {
+    uint64_t* page = bm->pages[word / BITMAP_PAGE_WORDS];
+    return page ? &page[word % BITMAP_PAGE_WORDS] : NULL;
+}
+
+bitmap_t* create_bitmap(size_t nbits) {
+    if (nbits < 1) nbits = 1;
+    bitmap_t* bm = malloc(sizeof(bitmap_t));
+    if (!bm) return NULL;
+    size_t words = words_for(nbits);
+    bm->nbits = nbits;
+    bm->count = 0;
+    bm->page_count = (words + BITMAP_PAGE_WORDS - 1) / BITMAP_PAGE_WORDS;
+    bm->pages_used = 0;
+    bm->summary = calloc(words_for(words), sizeof(uint64_t));
+    bm->pages = calloc(bm->page_count, sizeof(uint64_t*));
+    if (!bm->summary || !bm->pages) {
+        free(bm->summary);
+        free(bm->pages);
+        free(bm);
+        return NULL;
+    }
+    return bm;
+}
+
+int bitmap_resize(bitmap_t* bm, size_t nbits) {
+    if (nbits <= bm->nbits) return 0;
+    size_t old_summary = words_for(words_for(bm->nbits));
+    size_t summary_words = words_for(words_for(nbits));
+    size_t page_count = (words_for(nbits) + BITMAP_PAGE_WORDS - 1) / BITMAP_PAGE_WORDS;
+
+    uint64_t* summary = realloc(bm->summary, summary_words * sizeof(uint64_t));
+    if (!summary) return -1;
+    for (size_t i = old_summary; i < summary_words; i++) summary[i] = 0;
+    bm->summary = summary;
+
+    uint64_t** pages = realloc(bm->pages, page_count * sizeof(uint64_t*));
+    if (!pages) return -1;
+    for (size_t i = bm->page_count; i < page_count; i++) pages[i] = NULL;
+    bm->pages = pages;
+    bm->page_count = page_count;
+    bm->nbits = nbits;
+    return 0;
+}
+
+void bitmap_set(bitmap_t* bm, size_t bit) {
+    size_t word = bit / WORD_BITS;
+    uint64_t** page = &bm->pages[word / BITMAP_PAGE_WORDS];
+    if (*page == NULL) {
+        *page = calloc(BITMAP_PAGE_WORDS, sizeof(uint64_t));
+        if (*page == NULL) {
+            perror("Failed to grow bitmap");
+            exit(EXIT_FAILURE);
+        }
+        bm->pages_used++;
+    }
+    uint64_t* leaf = &(*page)[word % BITMAP_PAGE_WORDS];
+    uint64_t mask = (uint64_t)1 << (bit % WORD_BITS);
+    if (*leaf & mask) return;
+    *leaf |= mask;
+    bm->count++;
+    bm->summary[word / WORD_BITS] |= (uint64_t)1 << (word % WORD_BITS);
+}
+
+void bitmap_clear(bitmap_t* bm, size_t bit) {
+    size_t word = bit / WORD_BITS;
+    uint64_t* leaf = leaf_word(bm, word);
+    uint64_t mask = (uint64_t)1 << (bit % WORD_BITS);
+    if (!leaf || !(*leaf & mask)) return;
+    *leaf &= ~mask;
+    bm->count--;
+    if (*leaf == 0)
+        bm->summary[word / WORD_BITS] &= ~((uint64_t)1 << (word % WORD_BITS));
+}
+
+int bitmap_test(const bitmap_t* bm, size_t bit) {
+    const uint64_t* leaf = leaf_word(bm, bit / WORD_BITS);
+    return leaf && ((*leaf >> (bit % WORD_BITS)) & 1);
+}
+
+size_t bitmap_find_first(const bitmap_t* bm, size_t from) {
+    if (from >= bm->nbits || bm->count == 0) return BITMAP_NONE;
+
+    // Rest of the leaf word holding `from`
+    size_t word = from / WORD_BITS;
+    const uint64_t* leaf = leaf_word(bm, word);
+    if (leaf) {
+        uint64_t bits = *leaf & (~(uint64_t)0 << (from % WORD_BITS));
+        if (bits) return word * WORD_BITS + __builtin_ctzll(bits);
+    }
+
+    // Then the first non-zero leaf word after it, found through the summary
+    size_t words = words_for(bm->nbits);
+    size_t next = word + 1;
+    if (next >= words) return BITMAP_NONE;
+    size_t s = next / WORD_BITS;
+    uint64_t bits = bm->summary[s] & (~(uint64_t)0 << (next % WORD_BITS));
+    size_t summary_words = words_for(words);
+    while (bits == 0) {
+        if (++s >= summary_words) return BITMAP_NONE;
+        bits = bm->summary[s];
+    }
+    word = s * WORD_BITS + __builtin_ctzll(bits);
+    return word * WORD_BITS + __builtin_ctzll(*leaf_word(bm, word));
+}
+
+size_t bitmap_count(const bitmap_t* bm) {
+    return bm->count;
+}
+
+size_t bitmap_memory_size(const bitmap_t* bm) {
+    return sizeof(bitmap_t)
+        + words_for(words_for(bm->nbits)) * sizeof(uint64_t)
+        + bm->page_count * sizeof(uint64_t*)
+        + bm->pages_used * BITMAP_PAGE_WORDS * sizeof(uint64_t);
+}
+
+void destroy_bitmap(bitmap_t* bm) {
+    if (!bm) return;
+    for (size_t i = 0; i < bm->page_count; i++)
+        free(bm->pages[i]);
+    free(bm->pages);
+    free(bm->summary);
+    free(bm);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BITMAP_NONE SIZE_MAX
+#define BITMAP_PAGE_WORDS 64
+
+/*
+ * Two-level bitmap for "lowest set bit at or after i" queries. Leaf words
+ * live in pages of BITMAP_PAGE_WORDS that are only allocated when a bit in
+ * them is first set; a summary word marks which leaf words are non-zero, so
+ * a search skips 64 empty leaf words (4096 bits) per ctz.
+ */
+typedef struct bitmap {
+    size_t nbits;
+    size_t count;       // Set bits
+    uint64_t* summary;  // Bit w set while leaf word w is non-zero
+    uint64_t** pages;
+    size_t page_count;
+    size_t pages_used;
+} bitmap_t;
+
+bitmap_t* create_bitmap(size_t nbits);
+int bitmap_resize(bitmap_t* bm, size_t nbits);      // Grow to nbits, keeping every bit; 0 or -1
+void bitmap_set(bitmap_t* bm, size_t bit);
+void bitmap_clear(bitmap_t* bm, size_t bit);
+int bitmap_test(const bitmap_t* bm, size_t bit);
+size_t bitmap_find_first(const bitmap_t* bm, size_t from); // BITMAP_NONE if no bit >= from is set
+size_t bitmap_count(const bitmap_t* bm);
+size_t bitmap_memory_size(const bitmap_t* bm);
+void destroy_bitmap(bitmap_t* bm);
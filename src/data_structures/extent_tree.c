@@ -0,0 +1,231 @@
+#include "extent_tree.h"
+#include <stdlib.h>
+
+#define LEFT(node, t) ((node)->child[t][0])
+#define RIGHT(node, t) ((node)->child[t][1])
+
+static inline int height(const extent_t* node, int t) {
+    return node ? node->height[t] : 0;
+}
+
+static inline size_t max_size(const extent_t* node) {
+    return node ? node->max_size : 0;
+}
+
+// Order by offset, or by (size, offset); both keys are unique among disjoint extents
+static int compare(int t, const extent_t* a, const extent_t* b) {
+    if (t == EXTENT_BY_SIZE && a->size != b->size) {
+        return a->size < b->size ? -1 : 1;
+    }
+    if (a->offset != b->offset) {
+        return a->offset < b->offset ? -1 : 1;
+    }
+    return 0;
+}
+
+static void update(extent_t* node, int t) {
+    int left = height(LEFT(node, t), t);
+    int right = height(RIGHT(node, t), t);
+    node->height[t] = 1 + (left > right ? left : right);
+    if (t == EXTENT_BY_OFFSET) {
+        size_t largest = node->size;
+        if (max_size(LEFT(node, t)) > largest) largest = max_size(LEFT(node, t));
+        if (max_size(RIGHT(node, t)) > largest) largest = max_size(RIGHT(node, t));
+        node->max_size = largest;
+    }
+}
+
+// Rotate so that node's child on side `dir` becomes the subtree root
+static extent_t* rotate(extent_t* node, int t, int dir) {
+    extent_t* pivot = node->child[t][dir];
+    node->child[t][dir] = pivot->child[t][!dir];
+    pivot->child[t][!dir] = node;
+    update(node, t);
+    update(pivot, t);
+    return pivot;
+}
+
+static extent_t* rebalance(extent_t* node, int t) {
+    update(node, t);
+    int balance = height(LEFT(node, t), t) - height(RIGHT(node, t), t);
+    if (balance > 1) {
+        if (height(LEFT(LEFT(node, t), t), t) < height(RIGHT(LEFT(node, t), t), t)) {
+            LEFT(node, t) = rotate(LEFT(node, t), t, 1);
+        }
+        return rotate(node, t, 0);
+    }
+    if (balance < -1) {
+        if (height(RIGHT(RIGHT(node, t), t), t) < height(LEFT(RIGHT(node, t), t), t)) {
+            RIGHT(node, t) = rotate(RIGHT(node, t), t, 0);
+        }
+        return rotate(node, t, 1);
+    }
+    return node;
+}
+
+static extent_t* insert_node(extent_t* node, extent_t* extent, int t) {
+    if (!node) {
+        LEFT(extent, t) = RIGHT(extent, t) = NULL;
+        update(extent, t);
+        return extent;
+    }
+    int dir = compare(t, extent, node) > 0;
+    node->child[t][dir] = insert_node(node->child[t][dir], extent, t);
+    return rebalance(node, t);
+}
+
+static extent_t* remove_min(extent_t* node, int t, extent_t** min) {
+    if (!LEFT(node, t)) {
+        *min = node;
+        return RIGHT(node, t);
+    }
+    LEFT(node, t) = remove_min(LEFT(node, t), t, min);
+    return rebalance(node, t);
+}
+
+// Nodes live in two trees, so a removed node is replaced by relinking its
+// successor rather than by copying keys into it
+static extent_t* remove_node(extent_t* node, extent_t* extent, int t) {
+    if (!node) return NULL;
+    int cmp = compare(t, extent, node);
+    if (cmp != 0) {
+        int dir = cmp > 0;
+        node->child[t][dir] = remove_node(node->child[t][dir], extent, t);
+        return rebalance(node, t);
+    }
+    if (!LEFT(node, t)) return RIGHT(node, t);
+    if (!RIGHT(node, t)) return LEFT(node, t);
+    extent_t* successor;
+    extent_t* right = remove_min(RIGHT(node, t), t, &successor);
+    LEFT(successor, t) = LEFT(node, t);
+    RIGHT(successor, t) = right;
+    return rebalance(successor, t);
+}
+
+extent_tree_t* create_extent_tree() {
+    extent_tree_t* tree = malloc(sizeof(extent_tree_t));
+    if (!tree) return NULL;
+    tree->root[EXTENT_BY_OFFSET] = NULL;
+    tree->root[EXTENT_BY_SIZE] = NULL;
+    tree->count = 0;
+    tree->total_size = 0;
+    return tree;
+}
+
+extent_t* extent_tree_insert(extent_tree_t* tree, size_t offset, size_t size) {
+    extent_t* extent = malloc(sizeof(extent_t));
+    if (!extent) return NULL;
+    extent->offset = offset;
+    extent->size = size;
+    extent->next = extent->prev = NULL;
+    for (int t = 0; t < 2; t++) {
+        tree->root[t] = insert_node(tree->root[t], extent, t);
+    }
+    tree->count++;
+    tree->total_size += size;
+    return extent;
+}
+
+void extent_tree_remove(extent_tree_t* tree, extent_t* extent) {
+    for (int t = 0; t < 2; t++) {
+        tree->root[t] = remove_node(tree->root[t], extent, t);
+    }
+    tree->count--;
+    tree->total_size -= extent->size;
+    free(extent);
+}
+
+void extent_tree_update(extent_tree_t* tree, extent_t* extent, size_t offset, size_t size) {
+    for (int t = 0; t < 2; t++) {
+        tree->root[t] = remove_node(tree->root[t], extent, t);
+    }
+    tree->total_size += size - extent->size;
+    extent->offset = offset;
+    extent->size = size;
+    for (int t = 0; t < 2; t++) {
+        tree->root[t] = insert_node(tree->root[t], extent, t);
+    }
+}
+
+extent_t* extent_tree_find(const extent_tree_t* tree, size_t offset) {
+    extent_t* node = tree->root[EXTENT_BY_OFFSET];
+    while (node && node->offset != offset) {
+        node = node->child[EXTENT_BY_OFFSET][offset > node->offset];
+    }
+    return node;
+}
+
+extent_t* extent_tree_prev(const extent_tree_t* tree, size_t offset) {
+    extent_t* node = tree->root[EXTENT_BY_OFFSET];
+    extent_t* best = NULL;
+    while (node) {
+        if (node->offset < offset) {
+            best = node;
+            node = RIGHT(node, EXTENT_BY_OFFSET);
+        } else {
+            node = LEFT(node, EXTENT_BY_OFFSET);
+        }
+    }
+    return best;
+}
+
+extent_t* extent_tree_next(const extent_tree_t* tree, size_t offset) {
+    extent_t* node = tree->root[EXTENT_BY_OFFSET];
+    extent_t* best = NULL;
+    while (node) {
+        if (node->offset > offset) {
+            best = node;
+            node = LEFT(node, EXTENT_BY_OFFSET);
+        } else {
+            node = RIGHT(node, EXTENT_BY_OFFSET);
+        }
+    }
+    return best;
+}
+
+// Subtrees whose max_size is too small are skipped whole, so this only
+// descends along paths that can hold a fit
+static extent_t* first_fit(extent_t* node, size_t size, size_t from) {
+    if (!node || node->max_size < size) return NULL;
+    if (node->offset >= from) {
+        extent_t* left = first_fit(LEFT(node, EXTENT_BY_OFFSET), size, from);
+        if (left) return left;
+        if (node->size >= size) return node;
+    }
+    return first_fit(RIGHT(node, EXTENT_BY_OFFSET), size, from);
+}
+
+extent_t* extent_tree_first_fit(const extent_tree_t* tree, size_t size, size_t from) {
+    return first_fit(tree->root[EXTENT_BY_OFFSET], size, from);
+}
+
+extent_t* extent_tree_best_fit(const extent_tree_t* tree, size_t size) {
+    extent_t* node = tree->root[EXTENT_BY_SIZE];
+    extent_t* best = NULL;
+    while (node) {
+        if (node->size >= size) {
+            best = node;
+            node = LEFT(node, EXTENT_BY_SIZE);
+        } else {
+            node = RIGHT(node, EXTENT_BY_SIZE);
+        }
+    }
+    return best;
+}
+
+size_t extent_tree_largest(const extent_tree_t* tree) {
+    return max_size(tree->root[EXTENT_BY_OFFSET]);
+}
+
+static void destroy_nodes(extent_t* node) {
+    if (!node) return;
+    destroy_nodes(LEFT(node, EXTENT_BY_OFFSET));
+    destroy_nodes(RIGHT(node, EXTENT_BY_OFFSET));
+    free(node);
+}
+
+void destroy_extent_tree(extent_tree_t* tree) {
+    if (!tree) return;
+    destroy_nodes(tree->root[EXTENT_BY_OFFSET]);
+    free(tree);
+}
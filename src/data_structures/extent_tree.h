@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+
+#define EXTENT_BY_OFFSET 0
+#define EXTENT_BY_SIZE 1
+
+/*
+ * A free extent [offset, offset + size). Each node sits in two AVL trees at
+ * once: one ordered by offset, which is augmented with the largest size in
+ * every subtree, and one ordered by (size, offset).
+ */
+typedef struct extent {
+    size_t offset;
+    size_t size;
+    struct extent* child[2][2];  // [tree][left, right]
+    int height[2];
+    size_t max_size;             // Largest size in this node's offset-ordered subtree
+    struct extent* next;         // Free for the owner's use (e.g. size-class lists)
+    struct extent* prev;
+} extent_t;
+
+typedef struct extent_tree {
+    extent_t* root[2];
+    size_t count;
+    size_t total_size;
+} extent_tree_t;
+
+extent_tree_t* create_extent_tree();
+extent_t* extent_tree_insert(extent_tree_t* tree, size_t offset, size_t size);
+void extent_tree_remove(extent_tree_t* tree, extent_t* extent);
+// Move an extent to a new range in place of a remove followed by an insert
+void extent_tree_update(extent_tree_t* tree, extent_t* extent, size_t offset, size_t size);
+// Extent starting exactly at offset, or NULL
+extent_t* extent_tree_find(const extent_tree_t* tree, size_t offset);
+// Nearest extents strictly below / above offset, or NULL
+extent_t* extent_tree_prev(const extent_tree_t* tree, size_t offset);
+extent_t* extent_tree_next(const extent_tree_t* tree, size_t offset);
+// Lowest-offset extent at or after `from` with at least `size` bytes, or NULL
+extent_t* extent_tree_first_fit(const extent_tree_t* tree, size_t size, size_t from);
+// Smallest extent with at least `size` bytes (lowest offset among equals), or NULL
+extent_t* extent_tree_best_fit(const extent_tree_t* tree, size_t size);
+size_t extent_tree_largest(const extent_tree_t* tree);
+void destroy_extent_tree(extent_tree_t* tree);
@@ -3,4 +3,10 @@
 #include "deque.h"
 #include "queue.h"
 #include "linked_list.h"
-#include "min_heap.h"
\ No newline at end of file
+#include "min_heap.h"
+#include "index_heap.h"
+#include "index_queue.h"
+#include "timer_wheel.h"
+#include "bitmap.h"
+#include "extent_tree.h"
+#include "proc_map.h"
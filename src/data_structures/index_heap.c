@@ -0,0 +1,85 @@
+#include "index_heap.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static void heapify_up(index_heap_t* heap, int index) {
+    uint32_t item = heap->data[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (heap->compare(item, heap->data[parent]) >= 0)
+            break;
+        heap->data[index] = heap->data[parent];
+        index = parent;
+    }
+    heap->data[index] = item;
+}
+
+static void heapify_down(index_heap_t* heap, int index) {
+    uint32_t item = heap->data[index];
+    while (1) {
+        int child = 2 * index + 1;
+        if (child >= heap->size)
+            break;
+        if (child + 1 < heap->size && heap->compare(heap->data[child + 1], heap->data[child]) < 0)
+            child++;
+        if (heap->compare(heap->data[child], item) >= 0)
+            break;
+        heap->data[index] = heap->data[child];
+        index = child;
+    }
+    heap->data[index] = item;
+}
+
+index_heap_t* create_index_heap(int capacity, int (*compare)(uint32_t, uint32_t)) {
+    if (capacity < 1) capacity = 1;
+    index_heap_t* heap = malloc(sizeof(index_heap_t));
+    if (!heap) return NULL;
+    heap->data = malloc(sizeof(uint32_t) * capacity);
+    if (!heap->data) {
+        free(heap);
+        return NULL;
+    }
+    heap->size = 0;
+    heap->capacity = capacity;
+    heap->compare = compare;
+    return heap;
+}
+
+void index_heap_insert(index_heap_t* heap, uint32_t item) {
+    if (heap->size == heap->capacity) {
+        uint32_t* grown = realloc(heap->data, sizeof(uint32_t) * heap->capacity * 2);
+        if (!grown) {
+            perror("Failed to grow index heap");
+            exit(EXIT_FAILURE);
+        }
+        heap->data = grown;
+        heap->capacity *= 2;
+    }
+    heap->data[heap->size++] = item;
+    heapify_up(heap, heap->size - 1);
+}
+
+uint32_t index_heap_get_min(index_heap_t* heap) {
+    return heap->size > 0 ? heap->data[0] : INDEX_NONE;
+}
+
+uint32_t index_heap_extract_min(index_heap_t* heap) {
+    if (heap->size == 0) return INDEX_NONE;
+
+    uint32_t min = heap->data[0];
+    heap->data[0] = heap->data[--heap->size];
+    if (heap->size > 0)
+        heapify_down(heap, 0);
+
+    return min;
+}
+
+int index_heap_is_empty(index_heap_t* heap) {
+    return heap->size == 0;
+}
+
+void destroy_index_heap(index_heap_t* heap) {
+    if (!heap) return;
+    free(heap->data);
+    free(heap);
+}
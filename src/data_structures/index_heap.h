@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifndef INDEX_NONE
+#define INDEX_NONE UINT32_MAX
+#endif
+
+// Min heap of 32-bit slot indices. The comparator receives the indices and
+// resolves them against whatever table owns the slots.
+typedef struct index_heap {
+    uint32_t* data;
+    int size;
+    int capacity;
+    int (*compare)(uint32_t, uint32_t);
+} index_heap_t;
+
+index_heap_t* create_index_heap(int capacity, int (*compare)(uint32_t, uint32_t));
+void index_heap_insert(index_heap_t* heap, uint32_t item);
+uint32_t index_heap_get_min(index_heap_t* heap);
+uint32_t index_heap_extract_min(index_heap_t* heap);
+int index_heap_is_empty(index_heap_t* heap);
+void destroy_index_heap(index_heap_t* heap);
@@ -0,0 +1,59 @@
+#include "index_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+index_queue_t* create_index_queue(int capacity) {
+    if (capacity < 1) capacity = 1;
+    index_queue_t* q = malloc(sizeof(index_queue_t));
+    if (!q) return NULL;
+    q->data = malloc(sizeof(uint32_t) * capacity);
+    if (!q->data) {
+        free(q);
+        return NULL;
+    }
+    q->head = 0;
+    q->size = 0;
+    q->capacity = capacity;
+    return q;
+}
+
+void index_queue_push(index_queue_t* q, uint32_t item) {
+    if (q->size == q->capacity) {
+        uint32_t* grown = malloc(sizeof(uint32_t) * q->capacity * 2);
+        if (!grown) {
+            perror("Failed to grow index queue");
+            exit(EXIT_FAILURE);
+        }
+        // Unwrap the ring so the live entries start at index 0
+        for (int i = 0; i < q->size; i++)
+            grown[i] = q->data[(q->head + i) % q->capacity];
+        free(q->data);
+        q->data = grown;
+        q->head = 0;
+        q->capacity *= 2;
+    }
+    q->data[(q->head + q->size) % q->capacity] = item;
+    q->size++;
+}
+
+uint32_t index_queue_pop(index_queue_t* q) {
+    if (q->size == 0) return INDEX_NONE;
+    uint32_t item = q->data[q->head];
+    q->head = (q->head + 1) % q->capacity;
+    q->size--;
+    return item;
+}
+
+uint32_t index_queue_peek(index_queue_t* q) {
+    return q->size > 0 ? q->data[q->head] : INDEX_NONE;
+}
+
+int index_queue_is_empty(index_queue_t* q) {
+    return q->size == 0;
+}
+
+void destroy_index_queue(index_queue_t* q) {
+    if (!q) return;
+    free(q->data);
+    free(q);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifndef INDEX_NONE
+#define INDEX_NONE UINT32_MAX
+#endif
+
+// FIFO of 32-bit slot indices backed by a growable ring buffer, so enqueue
+// and dequeue do no heap traffic once the buffer has reached its working size.
+typedef struct index_queue {
+    uint32_t* data;
+    int head;
+    int size;
+    int capacity;
+} index_queue_t;
+
+index_queue_t* create_index_queue(int capacity);
+void index_queue_push(index_queue_t* q, uint32_t item);
+uint32_t index_queue_pop(index_queue_t* q);
+uint32_t index_queue_peek(index_queue_t* q);
+int index_queue_is_empty(index_queue_t* q);
+void destroy_index_queue(index_queue_t* q);
@@ -0,0 +1,230 @@
+#include "proc_map.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define EMPTY_KEY -1
+#define MIN_CAPACITY 16
+#define CACHE_LINE 64
+
+// Both tables hold fixed-size entries whose first field is the int key, so one set of
+// probing routines serves both
+
+static inline uint32_t hash_key(int key) {
+    uint32_t hash = (uint32_t)key * 0x9E3779B1u;
+    return hash ^ (hash >> 16);
+}
+
+static inline int* key_at(void* table, size_t stride, uint32_t slot) {
+    return (int*)((char*)table + stride * slot);
+}
+
+// Slot holding key, or the empty slot that ends its probe sequence
+static uint32_t probe(void* table, size_t stride, uint32_t capacity, int key) {
+    uint32_t mask = capacity - 1;
+    uint32_t slot = hash_key(key) & mask;
+    int current;
+    while ((current = *key_at(table, stride, slot)) != EMPTY_KEY && current != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void* alloc_table(size_t stride, uint32_t capacity) {
+    void* table = aligned_alloc(CACHE_LINE, stride * capacity);
+    if (!table) {
+        return NULL;
+    }
+    for (uint32_t slot = 0; slot < capacity; slot++) {
+        *key_at(table, stride, slot) = EMPTY_KEY;
+    }
+    return table;
+}
+
+static bool rehash(void** table, size_t stride, uint32_t* capacity, uint32_t new_capacity) {
+    void* resized = alloc_table(stride, new_capacity);
+    if (!resized) {
+        return false;
+    }
+    for (uint32_t slot = 0; slot < *capacity; slot++) {
+        int key = *key_at(*table, stride, slot);
+        if (key != EMPTY_KEY) {
+            memcpy(key_at(resized, stride, probe(resized, stride, new_capacity, key)),
+                   key_at(*table, stride, slot), stride);
+        }
+    }
+    free(*table);
+    *table = resized;
+    *capacity = new_capacity;
+    return true;
+}
+
+// Room for one more entry at a load factor of at most 1/2
+static bool reserve_slot(void** table, size_t stride, uint32_t* capacity, int count) {
+    if ((uint32_t)(count + 1) * 2 <= *capacity) {
+        return true;
+    }
+    return rehash(table, stride, capacity, *capacity * 2);
+}
+
+// Halve the table once it is mostly empty; failing to is harmless
+static void release_slots(void** table, size_t stride, uint32_t* capacity, int count) {
+    if (*capacity > MIN_CAPACITY && (uint32_t)count * 8 < *capacity) {
+        rehash(table, stride, capacity, *capacity / 2);
+    }
+}
+
+// Empty a slot, shifting back the entries after it that probed past it
+static void erase_slot(void* table, size_t stride, uint32_t capacity, uint32_t hole) {
+    uint32_t mask = capacity - 1;
+    for (uint32_t slot = (hole + 1) & mask; *key_at(table, stride, slot) != EMPTY_KEY; slot = (slot + 1) & mask) {
+        uint32_t home = hash_key(*key_at(table, stride, slot)) & mask;
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            memcpy(key_at(table, stride, hole), key_at(table, stride, slot), stride);
+            hole = slot;
+        }
+    }
+    *key_at(table, stride, hole) = EMPTY_KEY;
+}
+
+proc_map_t* create_proc_map(int capacity) {
+    proc_map_t* map = malloc(sizeof(proc_map_t));
+    if (!map) {
+        return NULL;
+    }
+    uint32_t slots = MIN_CAPACITY;
+    while (slots < (uint32_t)capacity * 2) {
+        slots <<= 1;
+    }
+    map->records = alloc_table(sizeof(proc_record_t), slots);
+    map->pids = alloc_table(sizeof(pid_entry_t), slots);
+    if (!map->records || !map->pids) {
+        free(map->records);
+        free(map->pids);
+        free(map);
+        return NULL;
+    }
+    map->record_capacity = map->pid_capacity = slots;
+    map->record_count = map->pid_count = 0;
+    return map;
+}
+
+void destroy_proc_map(proc_map_t* map) {
+    if (map == NULL) {
+        return;
+    }
+    free(map->records);
+    free(map->pids);
+    free(map);
+}
+
+proc_record_t* proc_map_get(proc_map_t* map, int id) {
+    if (id < 0) {
+        return NULL;
+    }
+    uint32_t slot = probe(map->records, sizeof(proc_record_t), map->record_capacity, id);
+    return map->records[slot].id == id ? &map->records[slot] : NULL;
+}
+
+proc_record_t* proc_map_put(proc_map_t* map, int id) {
+    proc_record_t* record = proc_map_get(map, id);
+    if (record || id < 0) {
+        return record;
+    }
+    if (!reserve_slot((void**)&map->records, sizeof(proc_record_t), &map->record_capacity, map->record_count)) {
+        return NULL;
+    }
+    record = &map->records[probe(map->records, sizeof(proc_record_t), map->record_capacity, id)];
+    record->id = id;
+    record->pid = -1;
+    record->offset = -1;
+    record->size = 0;
+    record->release_at = -1;
+    record->reserved = 0;
+    map->record_count++;
+    return record;
+}
+
+static void erase_pid(proc_map_t* map, int pid) {
+    uint32_t slot = probe(map->pids, sizeof(pid_entry_t), map->pid_capacity, pid);
+    if (map->pids[slot].pid != pid) {
+        return;
+    }
+    erase_slot(map->pids, sizeof(pid_entry_t), map->pid_capacity, slot);
+    map->pid_count--;
+    release_slots((void**)&map->pids, sizeof(pid_entry_t), &map->pid_capacity, map->pid_count);
+}
+
+void proc_map_remove(proc_map_t* map, int id) {
+    proc_record_t* record = proc_map_get(map, id);
+    if (!record) {
+        return;
+    }
+    if (record->pid != -1) {
+        erase_pid(map, record->pid);
+    }
+    erase_slot(map->records, sizeof(proc_record_t), map->record_capacity, record - map->records);
+    map->record_count--;
+    release_slots((void**)&map->records, sizeof(proc_record_t), &map->record_capacity, map->record_count);
+}
+
+void proc_map_foreach(proc_map_t* map, void (*visit)(proc_record_t* record, void* arg), void* arg) {
+    for (uint32_t slot = 0; slot < map->record_capacity; slot++) {
+        if (map->records[slot].id != -1) {
+            visit(&map->records[slot], arg);
+        }
+    }
+}
+
+int proc_map_id_of(const proc_map_t* map, int pid) {
+    if (pid < 0) {
+        return -1;
+    }
+    uint32_t slot = probe(map->pids, sizeof(pid_entry_t), map->pid_capacity, pid);
+    return map->pids[slot].pid == pid ? map->pids[slot].id : -1;
+}
+
+// A record left with neither memory nor a PID is dropped
+void proc_map_unbind_pid(proc_map_t* map, int pid) {
+    int id = proc_map_id_of(map, pid);
+    if (id == -1) {
+        return;
+    }
+    erase_pid(map, pid);
+    proc_record_t* record = proc_map_get(map, id);
+    if (record) {
+        record->pid = -1;
+        if (record->offset == -1) {
+            proc_map_remove(map, id);
+        }
+    }
+}
+
+bool proc_map_bind_pid(proc_map_t* map, int id, int pid) {
+    if (id < 0 || pid < 0) {
+        return false;
+    }
+    int current = proc_map_id_of(map, pid);
+    if (current == id) {
+        return true;
+    }
+    if (current != -1) {
+        proc_map_unbind_pid(map, pid);
+    }
+    if (!reserve_slot((void**)&map->pids, sizeof(pid_entry_t), &map->pid_capacity, map->pid_count)) {
+        return false;
+    }
+    proc_record_t* record = proc_map_put(map, id);
+    if (!record) {
+        return false;
+    }
+    if (record->pid != -1) {
+        erase_pid(map, record->pid);
+    }
+
+    pid_entry_t* entry = &map->pids[probe(map->pids, sizeof(pid_entry_t), map->pid_capacity, pid)];
+    entry->pid = pid;
+    entry->id = id;
+    map->pid_count++;
+    record->pid = pid;
+    return true;
+}
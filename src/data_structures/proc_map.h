@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Per-process records keyed by process ID, in an open-addressing hash table,
+ * with a second table indexing them by PID. Both use linear probing with
+ * backward-shift deletion, so there are no tombstones, and both shrink as
+ * processes leave: memory follows the number of live processes, however large
+ * the IDs and PIDs get.
+ */
+typedef struct proc_record {
+    int id;             // Key
+    int pid;            // -1 while no PID is bound
+    long offset;        // -1 while no memory is held
+    size_t size;
+    int release_at;     // Tick the memory is projected to be freed, -1 if unknown
+    int reserved;       // Pads records to 32 bytes, so none straddles a cache line
+} proc_record_t;
+
+typedef struct pid_entry {
+    int pid;            // Key
+    int id;
+} pid_entry_t;
+
+typedef struct proc_map {
+    proc_record_t* records;     // Unused slots have id -1
+    uint32_t record_capacity;   // Power of 2
+    int record_count;
+    pid_entry_t* pids;
+    uint32_t pid_capacity;      // Power of 2
+    int pid_count;
+} proc_map_t;
+
+proc_map_t* create_proc_map(int capacity);
+void destroy_proc_map(proc_map_t* map);
+
+// Record pointers stay valid only until the next put, remove or PID change
+proc_record_t* proc_map_get(proc_map_t* map, int id);   // NULL if absent
+proc_record_t* proc_map_put(proc_map_t* map, int id);   // Finds or adds; NULL if out of memory
+void proc_map_remove(proc_map_t* map, int id);          // Drops the record and its PID
+// Call visit on every record, in no particular order; visit must not put or remove
+void proc_map_foreach(proc_map_t* map, void (*visit)(proc_record_t* record, void* arg), void* arg);
+
+// Binding a PID moves it off any other record, and the record off any other PID
+bool proc_map_bind_pid(proc_map_t* map, int id, int pid);
+void proc_map_unbind_pid(proc_map_t* map, int pid);
+int proc_map_id_of(const proc_map_t* map, int pid);     // -1 if unbound
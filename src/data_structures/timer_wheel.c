@@ -0,0 +1,131 @@
+#include "timer_wheel.h"
+#include <stdlib.h>
+
+#define TW_MASK (TW_SLOTS - 1)
+
+static void link_timer(tw_timer_t** head, tw_timer_t* timer) {
+    timer->next = *head;
+    if (timer->next)
+        timer->next->pprev = &timer->next;
+    timer->pprev = head;
+    *head = timer;
+}
+
+static void unlink_timer(tw_timer_t* timer) {
+    *timer->pprev = timer->next;
+    if (timer->next)
+        timer->next->pprev = timer->pprev;
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+// Pick the level whose span covers the distance to expiry and link there
+static void place_timer(timer_wheel_t* wheel, tw_timer_t* timer) {
+    unsigned long expires = timer->expires;
+    if (expires < wheel->now)
+        expires = wheel->now;  // Already due: fire on the next processed tick
+
+    unsigned long delta = expires - wheel->now;
+    int level = 0;
+    while (level < TW_LEVELS - 1 && delta >= (1UL << (TW_SLOT_BITS * (level + 1))))
+        level++;
+
+    // Beyond the wheel's range: park in the farthest slot, it is re-placed on cascade
+    unsigned long max_delta = (1UL << (TW_SLOT_BITS * TW_LEVELS)) - 1;
+    if (delta > max_delta)
+        expires = wheel->now + max_delta;
+
+    int slot = (expires >> (TW_SLOT_BITS * level)) & TW_MASK;
+    link_timer(&wheel->slots[level][slot], timer);
+}
+
+// Move every timer in the current slot of `level` down to finer levels
+static int cascade(timer_wheel_t* wheel, int level) {
+    int slot = (wheel->now >> (TW_SLOT_BITS * level)) & TW_MASK;
+    tw_timer_t* timer = wheel->slots[level][slot];
+    wheel->slots[level][slot] = NULL;
+
+    while (timer) {
+        tw_timer_t* next = timer->next;
+        timer->next = NULL;
+        timer->pprev = NULL;
+        place_timer(wheel, timer);
+        timer = next;
+    }
+    return slot;
+}
+
+timer_wheel_t* create_timer_wheel(unsigned long now) {
+    timer_wheel_t* wheel = calloc(1, sizeof(timer_wheel_t));
+    if (!wheel) return NULL;
+    wheel->now = now;
+    wheel->pending = 0;
+    return wheel;
+}
+
+void tw_timer_init(tw_timer_t* timer, void (*fn)(tw_timer_t* timer, void* arg), void* arg) {
+    timer->expires = 0;
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->fn = fn;
+    timer->arg = arg;
+}
+
+int tw_timer_is_armed(const tw_timer_t* timer) {
+    return timer->pprev != NULL;
+}
+
+void timer_wheel_add(timer_wheel_t* wheel, tw_timer_t* timer, unsigned long expires) {
+    if (tw_timer_is_armed(timer))
+        timer_wheel_cancel(wheel, timer);
+    timer->expires = expires;
+    place_timer(wheel, timer);
+    wheel->pending++;
+}
+
+void timer_wheel_cancel(timer_wheel_t* wheel, tw_timer_t* timer) {
+    if (!tw_timer_is_armed(timer))
+        return;
+    unlink_timer(timer);
+    wheel->pending--;
+}
+
+/*
+ * Process every tick up to and including `now`, firing the timers due at
+ * each. Callbacks may arm or cancel timers. Returns the number fired.
+ */
+int timer_wheel_advance(timer_wheel_t* wheel, unsigned long now) {
+    int fired = 0;
+
+    while (wheel->now <= now) {
+        // Idle wheel: jump straight to the target instead of walking empty ticks
+        if (wheel->pending == 0) {
+            wheel->now = now + 1;
+            break;
+        }
+
+        int index = wheel->now & TW_MASK;
+        for (int level = 1; index == 0 && level < TW_LEVELS; level++)
+            index = cascade(wheel, level);
+
+        int slot = wheel->now & TW_MASK;
+        while (wheel->slots[0][slot]) {
+            tw_timer_t* timer = wheel->slots[0][slot];
+            unlink_timer(timer);
+            wheel->pending--;
+            fired++;
+            if (timer->fn)
+                timer->fn(timer, timer->arg);
+        }
+        wheel->now++;
+    }
+    return fired;
+}
+
+int timer_wheel_pending(timer_wheel_t* wheel) {
+    return wheel->pending;
+}
+
+void destroy_timer_wheel(timer_wheel_t* wheel) {
+    free(wheel);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stddef.h>
+
+#define TW_LEVELS 4
+#define TW_SLOT_BITS 6
+#define TW_SLOTS (1 << TW_SLOT_BITS)
+
+/*
+ * Intrusive timer. The owner embeds it (or keeps an array of them) and the
+ * wheel only links it, so arming and cancelling never allocate.
+ */
+typedef struct tw_timer {
+    unsigned long expires;
+    struct tw_timer* next;
+    struct tw_timer** pprev;  // Link that points at this timer, NULL when not armed
+    void (*fn)(struct tw_timer* timer, void* arg);
+    void* arg;
+} tw_timer_t;
+
+/*
+ * Hierarchical timing wheel. Level 0 has one slot per tick for the next
+ * TW_SLOTS ticks; each higher level covers TW_SLOTS times the span of the one
+ * below and is cascaded down as the wheel reaches it. Insert and cancel are
+ * O(1); advancing touches only the slot for each elapsed tick (plus a cascade
+ * every TW_SLOTS ticks).
+ */
+typedef struct timer_wheel {
+    tw_timer_t* slots[TW_LEVELS][TW_SLOTS];
+    unsigned long now;  // Next tick to be processed
+    int pending;
+} timer_wheel_t;
+
+timer_wheel_t* create_timer_wheel(unsigned long now);
+void tw_timer_init(tw_timer_t* timer, void (*fn)(tw_timer_t* timer, void* arg), void* arg);
+void timer_wheel_add(timer_wheel_t* wheel, tw_timer_t* timer, unsigned long expires);
+void timer_wheel_cancel(timer_wheel_t* wheel, tw_timer_t* timer);
+int timer_wheel_advance(timer_wheel_t* wheel, unsigned long now);
+int timer_wheel_pending(timer_wheel_t* wheel);
+int tw_timer_is_armed(const tw_timer_t* timer);
+void destroy_timer_wheel(timer_wheel_t* wheel);
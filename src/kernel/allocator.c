@@ -0,0 +1,268 @@
+#include "allocator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "buddy.h"
+#include "colors.h"
+
+static const char* policy_names[ALLOC_POLICY_COUNT] = {
+    [ALLOC_POLICY_BUDDY] = "buddy",
+    [ALLOC_POLICY_FIRST_FIT] = "first-fit",
+    [ALLOC_POLICY_NEXT_FIT] = "next-fit",
+    [ALLOC_POLICY_BEST_FIT] = "best-fit",
+    [ALLOC_POLICY_SEGREGATED_FIT] = "segregated-fit",
+};
+
+const char* alloc_policy_name(alloc_policy_t policy) {
+    if (policy == ALLOC_POLICY_MIXED) {
+        return "mixed";
+    }
+    if (policy < 0 || policy >= ALLOC_POLICY_COUNT) {
+        return "unknown";
+    }
+    return policy_names[policy];
+}
+
+int parse_alloc_policy(const char* name) {
+    for (int policy = 0; policy < ALLOC_POLICY_COUNT; policy++) {
+        if (strcmp(name, policy_names[policy]) == 0) {
+            return policy;
+        }
+    }
+    return -1;
+}
+
+/* Buddy policy: a thin wrapper, the buddy system already has every operation */
+
+static long buddy_policy_alloc(void* impl, size_t size, unsigned flags) {
+    return (flags & ALLOC_TRIM) ? buddy_alloc_trim(impl, size) : buddy_alloc(impl, size);
+}
+
+static int buddy_policy_free(void* impl, long offset) {
+    return buddy_free(impl, offset);
+}
+
+static size_t buddy_policy_alloc_size(void* impl, long offset) {
+    return buddy_alloc_size(impl, offset);
+}
+
+static void buddy_policy_stats(void* impl, allocator_stats_t* stats) {
+    buddy_stats_t buddy_stats;
+    buddy_get_stats(impl, &buddy_stats);
+    stats->total_bytes = buddy_get_size(impl);
+    stats->free_bytes = buddy_stats.free_bytes;
+    stats->largest_free = buddy_stats.largest_free;
+    stats->free_extents = 0;
+    for (int order = 0; order < BUDDY_STATS_ORDERS; order++) {
+        stats->free_extents += buddy_stats.free_blocks[order];
+    }
+}
+
+// Trimmed or not, a request still needs a free block of its rounded power of 2
+static bool buddy_policy_can_fit(void* impl, size_t size, unsigned flags) {
+    (void)flags;
+    size_t block = buddy_get_min_block(impl);
+    while (block < size) {
+        block <<= 1;
+    }
+    buddy_stats_t buddy_stats;
+    buddy_get_stats(impl, &buddy_stats);
+    return block <= buddy_stats.largest_free;
+}
+
+static int buddy_policy_alloc_batch(void* impl, const size_t sizes[], int n, long offsets[], unsigned flags) {
+    return buddy_alloc_batch(impl, sizes, n, offsets, flags & ALLOC_TRIM);
+}
+
+static int buddy_policy_free_batch(void* impl, const long offsets[], int n) {
+    return buddy_free_batch(impl, offsets, n);
+}
+
+static int buddy_policy_grow(void* impl, size_t new_size, bool independent_roots) {
+    return buddy_grow(impl, new_size, independent_roots);
+}
+
+static size_t buddy_policy_metadata_size(void* impl) {
+    return buddy_get_metadata_size(impl);
+}
+
+// The whole power-of-2 block, or with trimming only the min blocks the request needs
+static size_t buddy_policy_reserved_size(void* impl, size_t size, unsigned flags) {
+    size_t min_block = buddy_get_min_block(impl);
+    if (flags & ALLOC_TRIM) {
+        return (size + min_block - 1) / min_block * min_block;
+    }
+    size_t block = min_block;
+    while (block < size) {
+        block <<= 1;
+    }
+    return block;
+}
+
+static void buddy_policy_destroy(void* impl) {
+    buddy_destroy(impl);
+}
+
+static const allocator_ops_t buddy_policy_ops = {
+    .alloc = buddy_policy_alloc,
+    .free = buddy_policy_free,
+    .alloc_size = buddy_policy_alloc_size,
+    .stats = buddy_policy_stats,
+    .can_fit = buddy_policy_can_fit,
+    .alloc_batch = buddy_policy_alloc_batch,
+    .free_batch = buddy_policy_free_batch,
+    .grow = buddy_policy_grow,
+    .metadata_size = buddy_policy_metadata_size,
+    .reserved_size = buddy_policy_reserved_size,
+    .destroy = buddy_policy_destroy,
+};
+
+void* buddy_policy_create(size_t memory_size, size_t min_block, const allocator_ops_t** ops) {
+    *ops = &buddy_policy_ops;
+    return buddy_new(memory_size, min_block);
+}
+
+allocator_t* create_allocator(alloc_policy_t policy, size_t memory_size, size_t min_block) {
+    allocator_t* allocator = malloc(sizeof(allocator_t));
+    if (!allocator) {
+        return NULL;
+    }
+    allocator->policy = policy;
+    allocator->min_block = min_block;
+
+    switch (policy) {
+    case ALLOC_POLICY_BUDDY:
+        allocator->impl = buddy_policy_create(memory_size, min_block, &allocator->ops);
+        break;
+    case ALLOC_POLICY_FIRST_FIT:
+    case ALLOC_POLICY_NEXT_FIT:
+    case ALLOC_POLICY_BEST_FIT:
+    case ALLOC_POLICY_SEGREGATED_FIT:
+        allocator->impl = partition_policy_create(policy, memory_size, min_block, &allocator->ops);
+        break;
+    default:
+        allocator->impl = NULL;
+        break;
+    }
+
+    if (allocator->impl == NULL) {
+        if (DEBUG) {
+            printf(ANSI_COLOR_RED "[ALLOCATOR] Failed to create %s allocator\n" ANSI_COLOR_RESET,
+                alloc_policy_name(policy));
+        }
+        free(allocator);
+        return NULL;
+    }
+    return allocator;
+}
+
+void destroy_allocator(allocator_t* allocator) {
+    if (allocator == NULL) {
+        return;
+    }
+    allocator->ops->destroy(allocator->impl);
+    free(allocator);
+}
+
+long allocator_alloc(allocator_t* allocator, size_t size, unsigned flags) {
+    return allocator->ops->alloc(allocator->impl, size, flags);
+}
+
+int allocator_free(allocator_t* allocator, long offset) {
+    return allocator->ops->free(allocator->impl, offset);
+}
+
+size_t allocator_alloc_size(allocator_t* allocator, long offset) {
+    return allocator->ops->alloc_size(allocator->impl, offset);
+}
+
+void allocator_stats(allocator_t* allocator, allocator_stats_t* stats) {
+    allocator->ops->stats(allocator->impl, stats);
+}
+
+bool allocator_can_fit(allocator_t* allocator, size_t size, unsigned flags) {
+    return allocator->ops->can_fit(allocator->impl, size, flags);
+}
+
+typedef struct {
+    size_t size;
+    int slot;
+} batch_entry_t;
+
+static int batch_entry_compare(const void* a, const void* b) {
+    const batch_entry_t* ea = a;
+    const batch_entry_t* eb = b;
+    if (ea->size != eb->size) {
+        return ea->size > eb->size ? -1 : 1;
+    }
+    return ea->slot - eb->slot;
+}
+
+int allocator_alloc_batch(allocator_t* allocator, const size_t sizes[], int n, long offsets[], unsigned flags) {
+    if (allocator->ops->alloc_batch) {
+        return allocator->ops->alloc_batch(allocator->impl, sizes, n, offsets, flags);
+    }
+    if (n <= 0) {
+        return 0;
+    }
+
+    // Largest first, as the buddy batch does, so small requests do not take
+    // the space a larger one in the same burst needs
+    batch_entry_t* order = malloc(sizeof(batch_entry_t) * n);
+    if (!order) {
+        for (int i = 0; i < n; i++) {
+            offsets[i] = -1;
+        }
+        return 0;
+    }
+    for (int i = 0; i < n; i++) {
+        order[i].size = sizes[i];
+        order[i].slot = i;
+    }
+    qsort(order, n, sizeof(batch_entry_t), batch_entry_compare);
+
+    int allocated = 0;
+    for (int i = 0; i < n; i++) {
+        long offset = allocator_alloc(allocator, order[i].size, flags);
+        offsets[order[i].slot] = offset;
+        if (offset != -1) {
+            allocated++;
+        }
+    }
+    free(order);
+    return allocated;
+}
+
+int allocator_free_batch(allocator_t* allocator, const long offsets[], int n) {
+    if (allocator->ops->free_batch) {
+        return allocator->ops->free_batch(allocator->impl, offsets, n);
+    }
+    int result = 0;
+    for (int i = 0; i < n; i++) {
+        if (allocator_free(allocator, offsets[i]) == -1) {
+            result = -1;
+        }
+    }
+    return result;
+}
+
+int allocator_grow(allocator_t* allocator, size_t new_size, bool independent_roots) {
+    if (allocator->ops->grow == NULL) {
+        return -1;
+    }
+    return allocator->ops->grow(allocator->impl, new_size, independent_roots);
+}
+
+size_t allocator_metadata_size(allocator_t* allocator) {
+    if (allocator->ops->metadata_size == NULL) {
+        return 0;
+    }
+    return allocator->ops->metadata_size(allocator->impl);
+}
+
+size_t allocator_reserved_size(allocator_t* allocator, size_t size, unsigned flags) {
+    if (allocator->ops->reserved_size) {
+        return allocator->ops->reserved_size(allocator->impl, size, flags);
+    }
+    return (size + allocator->min_block - 1) / allocator->min_block * allocator->min_block;
+}
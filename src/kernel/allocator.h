@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "arena_limits.h"
+
+/*
+ * Common interface of the memory allocation policies. The memory manager only
+ * talks to an allocator_t; each policy supplies its operations and keeps its
+ * own state behind `impl`. Offsets and sizes are in bytes.
+ */
+
+typedef enum {
+    ALLOC_POLICY_BUDDY,
+    ALLOC_POLICY_FIRST_FIT,
+    ALLOC_POLICY_NEXT_FIT,
+    ALLOC_POLICY_BEST_FIT,
+    ALLOC_POLICY_SEGREGATED_FIT,
+    ALLOC_POLICY_COUNT,
+    ALLOC_POLICY_MIXED = ALLOC_POLICY_COUNT    // Arena set whose arenas differ in policy; never parsed
+} alloc_policy_t;
+
+#define ALLOC_TRIM 0x1  // Keep only the min blocks a request needs (policies that round up)
+
+typedef struct allocator_stats {
+    size_t total_bytes;
+    size_t free_bytes;          // Bytes not reserved by any allocation
+    size_t largest_free;        // Largest request that would fit right now
+    size_t free_extents;        // Free blocks or extents holding free_bytes
+} allocator_stats_t;
+
+typedef struct allocator_ops {
+    long (*alloc)(void* impl, size_t size, unsigned flags);
+    int (*free)(void* impl, long offset);
+    size_t (*alloc_size)(void* impl, long offset);
+    void (*stats)(void* impl, allocator_stats_t* stats);
+    bool (*can_fit)(void* impl, size_t size, unsigned flags);
+    // Optional: batches fall back to one call per request, largest first
+    int (*alloc_batch)(void* impl, const size_t sizes[], int n, long offsets[], unsigned flags);
+    int (*free_batch)(void* impl, const long offsets[], int n);
+    int (*grow)(void* impl, size_t new_size, bool independent_roots);
+    size_t (*metadata_size)(void* impl);
+    // Optional: without it an allocation reserves the request rounded up to whole min blocks
+    size_t (*reserved_size)(void* impl, size_t size, unsigned flags);
+    void (*destroy)(void* impl);
+} allocator_ops_t;
+
+typedef struct allocator {
+    alloc_policy_t policy;
+    const allocator_ops_t* ops;
+    void* impl;
+    size_t min_block;
+} allocator_t;
+
+// memory_size must be a whole number of min_block bytes; min_block a power of 2
+allocator_t* create_allocator(alloc_policy_t policy, size_t memory_size, size_t min_block);
+void destroy_allocator(allocator_t* allocator);
+
+// Policy name as used by --mem-policy, and back (-1 if unknown)
+const char* alloc_policy_name(alloc_policy_t policy);
+int parse_alloc_policy(const char* name);
+
+// Returns the offset, or -1 if no free space fits
+long allocator_alloc(allocator_t* allocator, size_t size, unsigned flags);
+// Returns 0, or -1 if no allocation starts at offset
+int allocator_free(allocator_t* allocator, long offset);
+// Bytes reserved by the allocation at offset (0 if none starts there)
+size_t allocator_alloc_size(allocator_t* allocator, long offset);
+void allocator_stats(allocator_t* allocator, allocator_stats_t* stats);
+// Whether allocator_alloc would succeed for size right now, without allocating
+bool allocator_can_fit(allocator_t* allocator, size_t size, unsigned flags);
+// offsets[i] is -1 for a request that did not fit; returns how many were allocated
+int allocator_alloc_batch(allocator_t* allocator, const size_t sizes[], int n, long offsets[], unsigned flags);
+// Returns 0 if all were freed, -1 if any offset was rejected (the valid ones are still freed)
+int allocator_free_batch(allocator_t* allocator, const long offsets[], int n);
+// Grow to new_size bytes keeping every offset; returns 0 or -1
+int allocator_grow(allocator_t* allocator, size_t new_size, bool independent_roots);
+size_t allocator_metadata_size(allocator_t* allocator);
+// Bytes an allocation of size would reserve, rounding included
+size_t allocator_reserved_size(allocator_t* allocator, size_t size, unsigned flags);
+
+/*
+ * Arenas: one allocator per range of a shared address space, each with its own policy,
+ * such as NUMA nodes or a DMA zone below a normal zone. Offsets are global; arena k
+ * starts where arena k - 1 ends. A placement policy picks the arena for each request,
+ * falling back to the others when it does not fit. At most MAX_ARENAS.
+ */
+
+typedef enum {
+    PLACEMENT_LOCAL_FIRST,      // Arena 0, where the allocating process runs, then the next ones in turn
+    PLACEMENT_INTERLEAVE,       // Round robin over the arenas
+    PLACEMENT_LEAST_LOADED,     // The arena with the most free memory
+    PLACEMENT_COUNT
+} placement_policy_t;
+
+typedef struct arena_spec {
+    size_t size;                // Whole min blocks
+    alloc_policy_t policy;
+} arena_spec_t;
+
+typedef struct arena_stats {
+    allocator_stats_t memory;
+    size_t base;                // Global offset of the arena's first byte
+    size_t peak_used;           // Most bytes reserved at once
+    int placed;                 // Allocations placed here so far
+    int spilled;                // ... of which the placement policy preferred another arena
+} arena_stats_t;
+
+// With `locked`, each arena has its own mutex so allocations from several threads only
+// contend when they land on the same arena. The allocator's policy is the arenas' own if
+// they all share one, ALLOC_POLICY_MIXED otherwise
+allocator_t* create_arena_allocator(const arena_spec_t specs[], int count, size_t min_block,
+                                    placement_policy_t placement, bool locked);
+const char* placement_policy_name(placement_policy_t placement);
+int parse_placement_policy(const char* name);
+// A plain allocator counts as one arena spanning all of it
+int allocator_arena_count(allocator_t* allocator);
+void allocator_arena_stats(allocator_t* allocator, int arena, arena_stats_t* stats);
+
+// Policy constructors, used by create_allocator
+void* buddy_policy_create(size_t memory_size, size_t min_block, const allocator_ops_t** ops);
+void* partition_policy_create(alloc_policy_t policy, size_t memory_size, size_t min_block,
+                              const allocator_ops_t** ops);
@@ -0,0 +1,341 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "allocator.h"
+#include "colors.h"
+
+/*
+ * Arenas:
+    * 1. Each arena is a complete allocator over its own range of the address space;
+    *    global offset = arena base + arena offset. Bases never move, so the arena of an
+    *    offset is the last one whose base is at or below it. Growing memory extends the
+    *    last arena, which is the only one with nothing above it.
+    * 2. Placement picks the first arena to try and the rest follow in index order,
+    *    wrapping around, so a request fails only if no arena can take it.
+    * 3. With locking, every operation on an arena holds that arena's mutex, including
+    *    least-loaded reading its free count; the interleave cursor is atomic. The pick
+    *    is still only a hint, as the counts may change before the allocation locks its
+    *    arena. Placement statistics are updated under the arena's lock.
+*/
+
+typedef struct arena {
+    allocator_t* memory;
+    size_t base;
+    size_t peak_used;
+    int placed;
+    int spilled;
+    pthread_mutex_t lock;
+} arena_t;
+
+typedef struct arena_set {
+    arena_t arenas[MAX_ARENAS];
+    int count;
+    placement_policy_t placement;
+    bool locked;
+    unsigned cursor;                // Interleave: next arena to start from
+} arena_set_t;
+
+static const char* placement_names[PLACEMENT_COUNT] = {
+    [PLACEMENT_LOCAL_FIRST] = "local",
+    [PLACEMENT_INTERLEAVE] = "interleave",
+    [PLACEMENT_LEAST_LOADED] = "least-loaded",
+};
+
+const char* placement_policy_name(placement_policy_t placement) {
+    if (placement < 0 || placement >= PLACEMENT_COUNT) {
+        return "unknown";
+    }
+    return placement_names[placement];
+}
+
+int parse_placement_policy(const char* name) {
+    for (int placement = 0; placement < PLACEMENT_COUNT; placement++) {
+        if (strcmp(name, placement_names[placement]) == 0) {
+            return placement;
+        }
+    }
+    return -1;
+}
+
+static inline void arena_lock(arena_set_t* self, arena_t* arena) {
+    if (self->locked) {
+        pthread_mutex_lock(&arena->lock);
+    }
+}
+
+static inline void arena_unlock(arena_set_t* self, arena_t* arena) {
+    if (self->locked) {
+        pthread_mutex_unlock(&arena->lock);
+    }
+}
+
+static arena_t* arena_of(arena_set_t* self, long offset) {
+    if (offset < 0) {
+        return NULL;
+    }
+    for (int k = self->count - 1; k >= 0; k--) {
+        if ((size_t)offset >= self->arenas[k].base) {
+            return &self->arenas[k];
+        }
+    }
+    return NULL;
+}
+
+// With `advance`, an interleaved pick moves the cursor on; without, it only looks
+static int first_choice(arena_set_t* self, bool advance) {
+    switch (self->placement) {
+    case PLACEMENT_INTERLEAVE:
+        if (!advance) {
+            return __atomic_load_n(&self->cursor, __ATOMIC_RELAXED) % self->count;
+        }
+        return __atomic_fetch_add(&self->cursor, 1, __ATOMIC_RELAXED) % self->count;
+    case PLACEMENT_LEAST_LOADED: {
+        int best = 0;
+        size_t most_free = 0;
+        for (int k = 0; k < self->count; k++) {
+            allocator_stats_t stats;
+            arena_lock(self, &self->arenas[k]);
+            allocator_stats(self->arenas[k].memory, &stats);
+            arena_unlock(self, &self->arenas[k]);
+            if (stats.free_bytes > most_free) {
+                most_free = stats.free_bytes;
+                best = k;
+            }
+        }
+        return best;
+    }
+    default:
+        return 0;
+    }
+}
+
+static long arena_alloc(void* impl, size_t size, unsigned flags) {
+    arena_set_t* self = impl;
+    int first = first_choice(self, true);
+    for (int i = 0; i < self->count; i++) {
+        arena_t* arena = &self->arenas[(first + i) % self->count];
+        arena_lock(self, arena);
+        long offset = allocator_alloc(arena->memory, size, flags);
+        if (offset != -1) {
+            allocator_stats_t stats;
+            allocator_stats(arena->memory, &stats);
+            if (stats.total_bytes - stats.free_bytes > arena->peak_used) {
+                arena->peak_used = stats.total_bytes - stats.free_bytes;
+            }
+            arena->placed++;
+            if (i > 0) {
+                arena->spilled++;
+            }
+            arena_unlock(self, arena);
+            if (DEBUG && i > 0) {
+                printf(ANSI_COLOR_CYAN "[ARENA] %zu bytes spilled over to arena %d\n" ANSI_COLOR_RESET,
+                    size, (first + i) % self->count);
+            }
+            return (long)arena->base + offset;
+        }
+        arena_unlock(self, arena);
+    }
+    return -1;
+}
+
+static int arena_free(void* impl, long offset) {
+    arena_set_t* self = impl;
+    arena_t* arena = arena_of(self, offset);
+    if (!arena) {
+        return -1;
+    }
+    arena_lock(self, arena);
+    int result = allocator_free(arena->memory, offset - (long)arena->base);
+    arena_unlock(self, arena);
+    return result;
+}
+
+static size_t arena_alloc_size(void* impl, long offset) {
+    arena_set_t* self = impl;
+    arena_t* arena = arena_of(self, offset);
+    if (!arena) {
+        return 0;
+    }
+    arena_lock(self, arena);
+    size_t size = allocator_alloc_size(arena->memory, offset - (long)arena->base);
+    arena_unlock(self, arena);
+    return size;
+}
+
+static void arena_stats(void* impl, allocator_stats_t* stats) {
+    arena_set_t* self = impl;
+    memset(stats, 0, sizeof(*stats));
+    for (int k = 0; k < self->count; k++) {
+        allocator_stats_t part;
+        arena_lock(self, &self->arenas[k]);
+        allocator_stats(self->arenas[k].memory, &part);
+        arena_unlock(self, &self->arenas[k]);
+        stats->total_bytes += part.total_bytes;
+        stats->free_bytes += part.free_bytes;
+        stats->free_extents += part.free_extents;
+        if (part.largest_free > stats->largest_free) {
+            stats->largest_free = part.largest_free;
+        }
+    }
+}
+
+// Placement falls back to every arena, so any one of them will do
+static bool arena_can_fit(void* impl, size_t size, unsigned flags) {
+    arena_set_t* self = impl;
+    for (int k = 0; k < self->count; k++) {
+        arena_lock(self, &self->arenas[k]);
+        bool fits = allocator_can_fit(self->arenas[k].memory, size, flags);
+        arena_unlock(self, &self->arenas[k]);
+        if (fits) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int arena_grow(void* impl, size_t new_size, bool independent_roots) {
+    arena_set_t* self = impl;
+    arena_t* last = &self->arenas[self->count - 1];
+    if (new_size <= last->base) {
+        return -1;
+    }
+    arena_lock(self, last);
+    int result = allocator_grow(last->memory, new_size - last->base, independent_roots);
+    arena_unlock(self, last);
+    return result;
+}
+
+static size_t arena_metadata_size(void* impl) {
+    arena_set_t* self = impl;
+    size_t size = sizeof(arena_set_t);
+    for (int k = 0; k < self->count; k++) {
+        size += sizeof(allocator_t) + allocator_metadata_size(self->arenas[k].memory);
+    }
+    return size;
+}
+
+// What the arena placement would put the request in takes; if none can take it now,
+// the most any arena would, so a projection does not count on the cheapest one
+static size_t arena_reserved_size(void* impl, size_t size, unsigned flags) {
+    arena_set_t* self = impl;
+    int first = first_choice(self, false);
+    size_t most = 0;
+    for (int i = 0; i < self->count; i++) {
+        arena_t* arena = &self->arenas[(first + i) % self->count];
+        arena_lock(self, arena);
+        bool fits = allocator_can_fit(arena->memory, size, flags);
+        size_t reserved = allocator_reserved_size(arena->memory, size, flags);
+        arena_unlock(self, arena);
+        if (fits) {
+            return reserved;
+        }
+        if (reserved > most) {
+            most = reserved;
+        }
+    }
+    return most;
+}
+
+static void arena_destroy(void* impl) {
+    arena_set_t* self = impl;
+    if (self == NULL) {
+        return;
+    }
+    for (int k = 0; k < self->count; k++) {
+        destroy_allocator(self->arenas[k].memory);
+        if (self->locked) {
+            pthread_mutex_destroy(&self->arenas[k].lock);
+        }
+    }
+    free(self);
+}
+
+static const allocator_ops_t arena_ops = {
+    .alloc = arena_alloc,
+    .free = arena_free,
+    .alloc_size = arena_alloc_size,
+    .stats = arena_stats,
+    .can_fit = arena_can_fit,
+    .grow = arena_grow,
+    .metadata_size = arena_metadata_size,
+    .reserved_size = arena_reserved_size,
+    .destroy = arena_destroy,
+};
+
+allocator_t* create_arena_allocator(const arena_spec_t specs[], int count, size_t min_block,
+                                    placement_policy_t placement, bool locked) {
+    if (count < 1 || count > MAX_ARENAS) {
+        return NULL;
+    }
+    arena_set_t* self = calloc(1, sizeof(arena_set_t));
+    allocator_t* allocator = malloc(sizeof(allocator_t));
+    if (!self || !allocator) {
+        free(self);
+        free(allocator);
+        return NULL;
+    }
+    self->placement = placement;
+    self->locked = locked;
+
+    size_t base = 0;
+    for (int k = 0; k < count; k++) {
+        arena_t* arena = &self->arenas[k];
+        arena->base = base;
+        arena->memory = create_allocator(specs[k].policy, specs[k].size, min_block);
+        if (arena->memory == NULL) {
+            if (DEBUG) {
+                printf(ANSI_COLOR_RED "[ARENA] Failed to create arena %d (%zu bytes, %s)\n" ANSI_COLOR_RESET,
+                    k, specs[k].size, alloc_policy_name(specs[k].policy));
+            }
+            arena_destroy(self);
+            free(allocator);
+            return NULL;
+        }
+        if (locked) {
+            pthread_mutex_init(&arena->lock, NULL);
+        }
+        self->count++;
+        base += specs[k].size;
+    }
+
+    allocator->policy = specs[0].policy;
+    for (int k = 1; k < count; k++) {
+        if (specs[k].policy != specs[0].policy) {
+            allocator->policy = ALLOC_POLICY_MIXED;
+        }
+    }
+    allocator->ops = &arena_ops;
+    allocator->impl = self;
+    allocator->min_block = min_block;
+    return allocator;
+}
+
+int allocator_arena_count(allocator_t* allocator) {
+    if (allocator->ops != &arena_ops) {
+        return 1;
+    }
+    return ((arena_set_t*)allocator->impl)->count;
+}
+
+void allocator_arena_stats(allocator_t* allocator, int arena, arena_stats_t* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (allocator->ops != &arena_ops) {
+        if (arena == 0) {
+            allocator_stats(allocator, &stats->memory);
+        }
+        return;
+    }
+    arena_set_t* self = allocator->impl;
+    if (arena < 0 || arena >= self->count) {
+        return;
+    }
+    arena_t* a = &self->arenas[arena];
+    arena_lock(self, a);
+    allocator_stats(a->memory, &stats->memory);
+    stats->base = a->base;
+    stats->peak_used = a->peak_used;
+    stats->placed = a->placed;
+    stats->spilled = a->spilled;
+    arena_unlock(self, a);
+}
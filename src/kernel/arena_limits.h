@@ -0,0 +1,5 @@
+#pragma once
+
+// Most arenas one memory can be split into; shared by the allocator and the
+// statistics segment, which keeps a fixed slot per arena
+#define MAX_ARENAS 8
@@ -2,59 +2,136 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <stdbool.h>
+#include <pthread.h>
 #include "buddy.h"
 #include "colors.h"
-#include "../data_structures/binary_tree.h"
+#include "../data_structures/bitmap.h"
+
+/*
+ * Layout of the buddy system:
+    * 1. The arena is split into min-block sized units. The tree spans 2^max_order of them,
+    *    the arena rounded up to a power of 2. A block of order k covers 2^k min blocks and
+    *    starts at a multiple of 2^k.
+    * 2. An arena that is not a power of 2 is seeded as a run of maximal aligned free blocks;
+    *    the tail past its end is covered by blocks marked permanently allocated, so nothing
+    *    ever coalesces across the end and the tail is never handed out.
+    * 3. The tree is divided into shard_count equal subtrees (shards) of order shard_order.
+    *    Each shard owns a free_area[k]: an occupancy bitmap with one bit per order-k position
+    *    in the shard, set while a free block starts there, plus a mask of the orders that
+    *    have any free block. The lowest free block of an order is a ctz away.
+    * 4. Each min block has a record holding the order of the allocated block starting there
+    *    (or BUDDY_ORDER_NONE) and the order of the free block starting there
+    *    (or BUDDY_ORDER_NONE). A buddy is free exactly when its free order matches.
+    * 5. A trimmed allocation keeps only the blocks its size needs: the set bits of the
+    *    request in min blocks, largest first, each recorded with its own order. The first
+    *    part is flagged BUDDY_EXTENT_MORE when others follow, the rest BUDDY_EXTENT_PART.
+    *    The unused tail of the rounded block goes back to the free bitmaps.
+    * 6. Records live in chunks of BUDDY_CHUNK_SIZE that are only allocated the first time
+    *    a block inside them is written. A subtree that was never split is described by its
+    *    head record alone, so a fresh arena of any size costs a single chunk per shard.
+*/
+
+/*
+ * Growth (buddy_grow):
+    * 1. Existing blocks keep their offsets. While the tree is smaller than the new size it
+    *    doubles: a single shard doubles its order, so the old tree becomes its left half;
+    *    a sharded buddy (or one asked for independent roots) doubles its shard count.
+    * 2. The doubled half starts permanently allocated, like the tail past the arena end.
+    *    The tail up to the new end is then released through the normal coalescing path,
+    *    which walks only the O(log n) tail blocks.
+*/
+
+/*
+ * Concurrency:
+    * 1. buddy_new builds a single shard and takes no locks.
+    * 2. buddy_new_concurrent builds several shards, each guarded by its own mutex. Blocks
+    *    never merge across a shard boundary, so requests up to the shard size only ever
+    *    lock one shard at a time; each thread starts at its own shard to spread the load.
+    * 3. Blocks larger than a shard take every shard lock, in index order, and claim a run
+    *    of entirely free shards.
+    * 4. Record chunks are published with a compare-and-swap, so shards that share a chunk
+    *    can materialize it concurrently.
+*/
 
 /*
  * Workflow of memory allocation:
-    * 1. Check if the requested size is a power of 2.
-    * 2. If not, round it up to the next power of 2.
-    * 3. Traverse the binary tree to find a suitable block.
-    * 4. If a suitable block is found, mark it as allocated.
-    * 5. Update the longest free block size for the parent nodes.
-    * 6. Return the offset of the allocated block.
- * 7. If no suitable block is found, return -1.
+    * 1. Round the requested bytes up to min blocks, then to the next power of 2, order k.
+    * 2. Take the lowest free block of the smallest order >= k that has one.
+    * 3. While the block is larger than order k, mark its upper half free one order down.
+    * 4. Record order k for the block and return its byte offset.
+    * 5. In trimmed mode, record only the parts the request covers and free the rest.
+    * 6. If no shard has a free block of order >= k, return -1.
 */
 
 /*
  * Workflow of memory deallocation:
-    * 1. Find the node representing the allocated block using its offset.
-    * 2. Mark the block as free.
-    * 3. Update the longest free block size for the parent nodes.
-    * 4. Check if the buddy block can be merged with this block.
-    * 5. If they can be merged, update the size and mark it as free.
-    * 6. Update the longest free block size for the parent nodes.
-    * 7. Continue merging until no more merges are possible.
- * 8. Return the updated longest free block size.
+    * 1. Read the block's order from its record; the sentinel means the offset was
+    *    never handed out or has already been freed, and the request is rejected.
+    * 2. While its buddy is free at the same order, take the buddy and continue with
+    *    the merged block one order up, stopping at the shard order.
+    * 3. Mark the final block free.
+    * 4. For a trimmed allocation, repeat for every part of the extent.
 */
 
 /*
- * Workflow of buddy system:
-    * 1. Initialize the buddy system with a given size.
-    * 2. Create a binary tree to manage memory blocks.
-    * 3. Each node in the tree represents a block of memory.
-    * 4. The size of each block is a power of 2.
-    * 5. The longest free block size is updated during allocation and deallocation.
-    * 6. The buddy system allows for efficient memory allocation and deallocation.
+ * Batches (buddy_alloc_batch / buddy_free_batch):
+    * 1. The whole batch runs under every shard lock, taken once.
+    * 2. Allocations are placed largest first, so small requests do not split the blocks
+    *    that larger requests in the same burst need.
+    * 3. Frees detach every block first and mark it pending at its order, then coalesce
+    *    one order at a time, smallest first. Blocks freed together merge with each other
+    *    before anything is published, and only the final merged blocks reach the bitmaps.
 */
 
-#define max(a, b) (((a)>(b))?(a):(b))
+#define BUDDY_NONE UINT32_MAX
+#define BUDDY_ORDER_NONE UINT8_MAX
+#define BUDDY_ORDER_MASK 0x1f
+#define BUDDY_EXTENT_MORE 0x20  // Another part of the same allocation follows this block
+#define BUDDY_EXTENT_PART 0x40  // Not the first block of its allocation
+#define BUDDY_FREE_PENDING 0x80 // Freed by a batch, not yet coalesced or published
+#define BUDDY_MAX_ORDER 31
+#define BUDDY_CHUNK_SHIFT 10
+#define BUDDY_CHUNK_SIZE (1u << BUDDY_CHUNK_SHIFT)
+
+typedef struct buddy_block {
+    uint8_t order;          // Order (and extent flags) of the allocated block starting here
+    uint8_t free_order;     // Order of the free block starting here
+} buddy_block_t;
 
-typedef struct buddy_node_data {
-    size_t size;        
-    size_t longest_free;
-    int offset;       
-    bool is_allocated;
-    int pid;        
-} buddy_node_data_t;
+typedef struct free_area {
+    bitmap_t* map;          // Bit i set while a free block starts at shard base + (i << order)
+} free_area_t;
+
+typedef struct buddy_shard {
+    pthread_mutex_t lock;
+    uint32_t nonempty;      // Bit k set while free_area[k] has a block
+    size_t free_units;      // Min blocks held by free blocks of this shard
+    free_area_t free_area[BUDDY_MAX_ORDER + 1];
+} __attribute__((aligned(64))) buddy_shard_t;
 
 struct buddy {
-    size_t size;        
-    binary_tree_t* tree;   
+    size_t size;            // Arena size in bytes
+    size_t min_block;       // Bytes per min block, a power of 2
+    int min_shift;          // log2(min_block)
+    int max_order;
+    int shard_order;        // Every shard covers 2^shard_order min blocks
+    unsigned shard_count;
+    bool concurrent;        // Take shard locks
+    buddy_shard_t* shards;
+    buddy_block_t** chunks; // Lazily allocated record chunks
+    size_t chunk_count;
+    size_t chunks_used;
 };
 
+// Read-only stand-in for records in chunks that were never written
+static const buddy_block_t unused_block = { BUDDY_ORDER_NONE, BUDDY_ORDER_NONE };
+
+// Shard a thread tries first; assigned round robin on its first allocation
+static __thread unsigned shard_hint = UINT32_MAX;
+static unsigned next_shard_hint = 0;
+
 static void *b_malloc(size_t size)
 {
     void *tmp = malloc(size);
@@ -65,115 +142,454 @@ static void *b_malloc(size_t size)
     return tmp;
 }
 
-static inline bool is_power_of_2(int index)
+static inline bool is_power_of_2(size_t index)
 {
     return !(index & (index - 1));
 }
 
-static inline unsigned next_power_of_2(unsigned x)
+// Smallest k with 2^k >= x
+static inline int order_of(size_t x)
 {
-    if (is_power_of_2(x)) {
-        return x;
+    int order = 0;
+    while (((size_t)1 << order) < x) {
+        order++;
     }
+    return order;
+}
 
-    x--;
-    x |= x >> 1;
-    x |= x >> 2;
-    x |= x >> 4;
-    x |= x >> 8;
-    x |= x >> 16;
-    x++;
-    
-    return x;
+static inline const buddy_block_t* peek_block(const struct buddy *self, uint32_t index)
+{
+    const buddy_block_t* chunk = __atomic_load_n(&self->chunks[index >> BUDDY_CHUNK_SHIFT], __ATOMIC_ACQUIRE);
+    return chunk ? &chunk[index & (BUDDY_CHUNK_SIZE - 1)] : &unused_block;
+}
+
+// Record for writing, materializing its chunk on first use
+static inline buddy_block_t* touch_block(struct buddy *self, uint32_t index)
+{
+    buddy_block_t** slot = &self->chunks[index >> BUDDY_CHUNK_SHIFT];
+    buddy_block_t* chunk = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if (chunk == NULL) {
+        buddy_block_t* fresh = b_malloc(sizeof(buddy_block_t) * BUDDY_CHUNK_SIZE);
+        for (uint32_t i = 0; i < BUDDY_CHUNK_SIZE; i++) {
+            fresh[i] = unused_block;
+        }
+        if (__atomic_compare_exchange_n(slot, &chunk, fresh, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            chunk = fresh;
+            __atomic_fetch_add(&self->chunks_used, 1, __ATOMIC_RELAXED);
+        } else {
+            free(fresh);    // Another shard published it first
+        }
+    }
+    return &chunk[index & (BUDDY_CHUNK_SIZE - 1)];
 }
 
+static inline buddy_shard_t* shard_of(struct buddy *self, uint32_t index)
+{
+    return &self->shards[index >> self->shard_order];
+}
 
-// Compare function for buddy nodes based on offset
-static int buddy_node_compare(const void* a, const void* b)
+static inline void shard_lock(struct buddy *self, buddy_shard_t* shard)
 {
-    buddy_node_data_t* node_a = (buddy_node_data_t*)a;
-    buddy_node_data_t* node_b = (buddy_node_data_t*)b;
-    
-    return node_a->offset - node_b->offset;
+    if (self->concurrent) {
+        pthread_mutex_lock(&shard->lock);
+    }
 }
 
-// Update the longest_free value of a node based on its children
-static void update_longest_free(bt_node_t* node)
+static inline void shard_unlock(struct buddy *self, buddy_shard_t* shard)
 {
-    if (!node) return;
-    
-    buddy_node_data_t* data = (buddy_node_data_t*)node->data;
-    
-    if (!node->left && !node->right) {
-        // Leaf node
-        data->longest_free = data->is_allocated ? 0 : data->size;
-        return;
+    if (self->concurrent) {
+        pthread_mutex_unlock(&shard->lock);
     }
-    
-    buddy_node_data_t* left_data = node->left ? (buddy_node_data_t*)node->left->data : NULL;
-    buddy_node_data_t* right_data = node->right ? (buddy_node_data_t*)node->right->data : NULL;
-    
-    size_t left_longest = left_data ? left_data->longest_free : 0;
-    size_t right_longest = right_data ? right_data->longest_free : 0;
-    
-    if (!data->is_allocated) {
-        // If this block is free, it could be the longest
-        data->longest_free = data->size;
-    } else {
-        // Otherwise, the longest is the max of children
-        data->longest_free = max(left_longest, right_longest);
+}
+
+static void lock_all(struct buddy *self)
+{
+    for (unsigned i = 0; i < self->shard_count; i++) {
+        shard_lock(self, &self->shards[i]);
     }
 }
 
-// Recursively build the buddy tree
-static bt_node_t* build_buddy_tree(binary_tree_t* tree, size_t size, int offset)
+static void unlock_all(struct buddy *self)
 {
-    buddy_node_data_t node_data;
-    node_data.size = size;
-    node_data.longest_free = size;
-    node_data.offset = offset;
-    node_data.is_allocated = false;
-    node_data.pid = -1;
-    
-    bt_node_t* node = bt_create_node(tree, &node_data);
-    
-    if (size > 1) {
-        size_t child_size = size / 2;
-        
-        node->left = build_buddy_tree(tree, child_size, offset);
-        if (node->left) node->left->parent = node;
-        
-        node->right = build_buddy_tree(tree, child_size, offset + child_size);
-        if (node->right) node->right->parent = node;
+    for (unsigned i = self->shard_count; i-- > 0;) {
+        shard_unlock(self, &self->shards[i]);
     }
-    
-    return node;
 }
 
-struct buddy *buddy_new(unsigned num_of_fragments)
+// Position of a block inside its shard's order-`order` bitmap
+static inline size_t area_bit(struct buddy *self, int order, uint32_t index)
 {
-    if (num_of_fragments < 1 || !is_power_of_2(num_of_fragments)) {
+    return (index & ((1u << self->shard_order) - 1)) >> order;
+}
+
+static void free_area_push(struct buddy *self, buddy_shard_t* shard, int order, uint32_t index)
+{
+    touch_block(self, index)->free_order = order;
+    bitmap_set(shard->free_area[order].map, area_bit(self, order, index));
+    __atomic_store_n(&shard->nonempty, shard->nonempty | (1u << order), __ATOMIC_RELAXED);
+    shard->free_units += (size_t)1 << order;
+}
+
+static void free_area_remove(struct buddy *self, buddy_shard_t* shard, int order, uint32_t index)
+{
+    bitmap_t* map = shard->free_area[order].map;
+
+    touch_block(self, index)->free_order = BUDDY_ORDER_NONE;
+    bitmap_clear(map, area_bit(self, order, index));
+    shard->free_units -= (size_t)1 << order;
+    if (bitmap_count(map) == 0) {
+        __atomic_store_n(&shard->nonempty, shard->nonempty & ~(1u << order), __ATOMIC_RELAXED);
+    }
+}
+
+// Return a block to the free bitmaps, merging it with its buddy while the buddy is free
+// at the same order; the caller holds the shard's lock
+static void release_block(struct buddy *self, buddy_shard_t* shard, uint32_t index, int order)
+{
+    while (order < self->shard_order) {
+        uint32_t buddy = index ^ ((uint32_t)1 << order);
+        if (peek_block(self, buddy)->free_order != order) {
+            break;
+        }
+        free_area_remove(self, shard, order, buddy);
+        if (buddy < index) {
+            index = buddy;
+        }
+        order++;
+    }
+    free_area_push(self, shard, order, index);
+}
+
+// Cover blocks [lo, hi) of one shard with maximal aligned blocks, free or permanently allocated
+static void seed_range(struct buddy *self, buddy_shard_t* shard, uint32_t lo, uint32_t hi, bool free_blocks)
+{
+    while (lo < hi) {
+        int order = lo ? __builtin_ctz(lo) : self->shard_order;
+        if (order > self->shard_order) {
+            order = self->shard_order;
+        }
+        while (lo + ((uint32_t)1 << order) > hi) {
+            order--;
+        }
+
+        if (free_blocks) {
+            release_block(self, shard, lo, order);
+        } else {
+            touch_block(self, lo)->order = order;
+        }
+        lo += (uint32_t)1 << order;
+    }
+}
+
+// Keep the first `need` min blocks of an allocated order-`order` block and free the tail;
+// the caller holds the lock of every shard the block covers
+static void trim_block(struct buddy *self, uint32_t index, int order, uint32_t need)
+{
+    uint32_t lo = index;
+    for (int part = order - 1; part >= 0; part--) {
+        if (!(need & (1u << part))) {
+            continue;
+        }
+        uint8_t flags = (lo != index ? BUDDY_EXTENT_PART : 0)
+            | ((need & ((1u << part) - 1)) ? BUDDY_EXTENT_MORE : 0);
+        touch_block(self, lo)->order = part | flags;
+        lo += 1u << part;
+    }
+
+    uint32_t hi = index + (1u << order);
+    while (lo < hi) {
+        uint32_t shard_end = ((lo >> self->shard_order) + 1) << self->shard_order;
+        uint32_t end = shard_end < hi ? shard_end : hi;
+        seed_range(self, shard_of(self, lo), lo, end, true);
+        lo = end;
+    }
+}
+
+// Allocate an order-`order` block inside one shard, trimmed to `need` min blocks;
+// the caller holds its lock
+static uint32_t shard_alloc(struct buddy *self, buddy_shard_t* shard, int order, uint32_t need)
+{
+    uint32_t candidates = shard->nonempty >> order;
+    if (candidates == 0) {
+        return BUDDY_NONE;
+    }
+
+    // Lowest free block of the smallest order that can hold the request
+    int current = order + __builtin_ctz(candidates);
+    uint32_t base = (uint32_t)(shard - self->shards) << self->shard_order;
+    uint32_t index = base + ((uint32_t)bitmap_find_first(shard->free_area[current].map, 0) << current);
+    free_area_remove(self, shard, current, index);
+
+    // Split down to the requested order, returning each upper half to the free lists
+    while (current > order) {
+        current--;
+        free_area_push(self, shard, current, index + ((uint32_t)1 << current));
+    }
+    touch_block(self, index)->order = order;
+    if (need < (1u << order)) {
+        trim_block(self, index, order, need);
+    }
+    return index;
+}
+
+// Claim a run of entirely free shards for a block larger than one shard;
+// the caller holds every lock
+static uint32_t claim_shards(struct buddy *self, int order, uint32_t need)
+{
+    unsigned span = 1u << (order - self->shard_order);
+    uint32_t result = BUDDY_NONE;
+
+    for (unsigned first = 0; first < self->shard_count && result == BUDDY_NONE; first += span) {
+        unsigned s;
+        for (s = first; s < first + span; s++) {
+            if (!(self->shards[s].nonempty & (1u << self->shard_order))) {
+                break;
+            }
+        }
+        if (s < first + span) {
+            continue;
+        }
+
+        for (s = first; s < first + span; s++) {
+            free_area_remove(self, &self->shards[s], self->shard_order, s << self->shard_order);
+        }
+        result = first << self->shard_order;
+        touch_block(self, result)->order = order;
+        if (need < (1u << order)) {
+            trim_block(self, result, order, need);
+        }
+    }
+    return result;
+}
+
+static uint32_t multi_shard_alloc(struct buddy *self, int order, uint32_t need)
+{
+    lock_all(self);
+    uint32_t result = claim_shards(self, order, need);
+    unlock_all(self);
+    return result;
+}
+
+// Empty shard: its lock and one occupancy bitmap per order up to the shard order
+static void init_shard(struct buddy *self, buddy_shard_t* shard)
+{
+    pthread_mutex_init(&shard->lock, NULL);
+    shard->nonempty = 0;
+    shard->free_units = 0;
+    for (int order = 0; order <= BUDDY_MAX_ORDER; order++) {
+        shard->free_area[order].map = NULL;
+        if (order <= self->shard_order) {
+            shard->free_area[order].map = create_bitmap((size_t)1 << (self->shard_order - order));
+            if (shard->free_area[order].map == NULL) {
+                fprintf(stderr, "my_malloc: not enough memory, quit\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+}
+
+static struct buddy *buddy_create(size_t arena_size, size_t min_block, unsigned shards, bool concurrent)
+{
+    if (min_block < 1 || !is_power_of_2(min_block) || arena_size < min_block) {
         return NULL;
     }
-    
-    struct buddy *self = (struct buddy*)b_malloc(sizeof(struct buddy));
-    self->size = num_of_fragments;
-    
-    // Create binary tree for buddy system
-    self->tree = bt_create(sizeof(buddy_node_data_t), buddy_node_compare);
-    
-    // Build the initial tree
-    self->tree->root = build_buddy_tree(self->tree, num_of_fragments, 0);
-    
+    if (order_of(arena_size / min_block) > BUDDY_MAX_ORDER || shards < 1 || !is_power_of_2(shards)) {
+        return NULL;  // Block indices must fit in 32 bits
+    }
+
+    // Only whole min blocks are usable
+    uint32_t arena_blocks = arena_size / min_block;
+
+    struct buddy *self = b_malloc(sizeof(struct buddy));
+    self->size = (size_t)arena_blocks * min_block;
+    self->min_block = min_block;
+    self->min_shift = order_of(min_block);
+    self->max_order = order_of(arena_blocks);
+    self->concurrent = concurrent;
+
+    // Shards cannot be smaller than one min block
+    if (order_of(shards) > self->max_order) {
+        shards = 1u << self->max_order;
+    }
+    self->shard_count = shards;
+    self->shard_order = self->max_order - order_of(shards);
+
+    size_t block_count = (size_t)1 << self->max_order;
+    self->chunk_count = (block_count + BUDDY_CHUNK_SIZE - 1) >> BUDDY_CHUNK_SHIFT;
+    self->chunks_used = 0;
+    self->chunks = calloc(self->chunk_count, sizeof(buddy_block_t*));
+    if (self->chunks == NULL) {
+        fprintf(stderr, "my_malloc: not enough memory, quit\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (posix_memalign((void**)&self->shards, 64, sizeof(buddy_shard_t) * shards) != 0) {
+        fprintf(stderr, "my_malloc: not enough memory, quit\n");
+        exit(EXIT_FAILURE);
+    }
+    for (unsigned s = 0; s < shards; s++) {
+        buddy_shard_t* shard = &self->shards[s];
+        init_shard(self, shard);
+
+        // Free up to the end of the arena, permanently allocated past it
+        uint32_t base = s << self->shard_order;
+        uint32_t end = base + ((uint32_t)1 << self->shard_order);
+        uint32_t split = arena_blocks < base ? base : arena_blocks < end ? arena_blocks : end;
+        seed_range(self, shard, base, split, true);
+        seed_range(self, shard, split, end, false);
+    }
+
     return self;
 }
 
+struct buddy *buddy_new(size_t arena_size, size_t min_block)
+{
+    return buddy_create(arena_size, min_block, 1, false);
+}
+
+struct buddy *buddy_new_concurrent(size_t arena_size, size_t min_block, unsigned shards)
+{
+    return buddy_create(arena_size, min_block, shards, true);
+}
+
+// Extend the record chunk table to cover the whole tree after it doubled
+static void grow_chunks(struct buddy *self)
+{
+    size_t chunk_count = (((size_t)1 << self->max_order) + BUDDY_CHUNK_SIZE - 1) >> BUDDY_CHUNK_SHIFT;
+    if (chunk_count <= self->chunk_count) {
+        return;
+    }
+    buddy_block_t** chunks = realloc(self->chunks, sizeof(buddy_block_t*) * chunk_count);
+    if (chunks == NULL) {
+        fprintf(stderr, "my_malloc: not enough memory, quit\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = self->chunk_count; i < chunk_count; i++) {
+        chunks[i] = NULL;
+    }
+    self->chunks = chunks;
+    self->chunk_count = chunk_count;
+}
+
+// Double the only shard: the old tree becomes its left half, and the new right half
+// starts out as one permanently allocated block
+static void double_root(struct buddy *self)
+{
+    buddy_shard_t* shard = &self->shards[0];
+    int order = ++self->shard_order;
+    self->max_order++;
+
+    // Positions inside the shard keep their bits; each order just gets room for the right half
+    for (int k = 0; k < order; k++) {
+        if (bitmap_resize(shard->free_area[k].map, (size_t)1 << (order - k)) == -1) {
+            fprintf(stderr, "my_malloc: not enough memory, quit\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    shard->free_area[order].map = create_bitmap(1);
+    if (shard->free_area[order].map == NULL) {
+        fprintf(stderr, "my_malloc: not enough memory, quit\n");
+        exit(EXIT_FAILURE);
+    }
+
+    grow_chunks(self);
+    touch_block(self, (uint32_t)1 << (order - 1))->order = order - 1;
+}
+
+// Double the shard count: the new shards are independent roots beside the old tree,
+// each one permanently allocated block to begin with
+static void add_roots(struct buddy *self)
+{
+    unsigned old_count = self->shard_count;
+    buddy_shard_t* shards;
+    if (posix_memalign((void**)&shards, 64, sizeof(buddy_shard_t) * old_count * 2) != 0) {
+        fprintf(stderr, "my_malloc: not enough memory, quit\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(shards, self->shards, sizeof(buddy_shard_t) * old_count);
+    for (unsigned s = 0; s < old_count; s++) {
+        pthread_mutex_destroy(&self->shards[s].lock);
+        pthread_mutex_init(&shards[s].lock, NULL);
+    }
+    free(self->shards);
+    self->shards = shards;
+    self->shard_count = old_count * 2;
+    self->max_order++;
+
+    grow_chunks(self);
+    for (unsigned s = old_count; s < self->shard_count; s++) {
+        init_shard(self, &shards[s]);
+        touch_block(self, s << self->shard_order)->order = self->shard_order;
+    }
+}
+
+// Free min blocks [lo, hi) of the permanently allocated tail; blocks that straddle hi
+// keep their part past it allocated
+static void release_tail(struct buddy *self, uint32_t lo, uint32_t hi)
+{
+    while (lo < hi) {
+        buddy_block_t* block = touch_block(self, lo);
+        uint32_t end = lo + ((uint32_t)1 << block->order);
+        buddy_shard_t* shard = shard_of(self, lo);
+
+        block->order = BUDDY_ORDER_NONE;
+        if (end > hi) {
+            seed_range(self, shard, hi, end, false);
+            end = hi;
+        }
+        seed_range(self, shard, lo, end, true);
+        lo = end;
+    }
+}
+
+int buddy_grow(struct buddy *self, size_t new_size, bool independent_roots)
+{
+    if (self == NULL) {
+        return -1;
+    }
+
+    size_t blocks = new_size >> self->min_shift;
+    uint32_t old_blocks = self->size >> self->min_shift;
+    if (blocks <= old_blocks || order_of(blocks) > BUDDY_MAX_ORDER) {
+        if (DEBUG) {
+            printf(ANSI_COLOR_RED "[BUDDY] Cannot grow from %zu to %zu bytes\n" ANSI_COLOR_RESET,
+                self->size, new_size);
+        }
+        return -1;
+    }
+
+    // A sharded buddy never merges across shards, so it always grows by adding them
+    while (((size_t)1 << self->max_order) < blocks) {
+        if (independent_roots || self->shard_count > 1) {
+            add_roots(self);
+        } else {
+            double_root(self);
+        }
+    }
+    release_tail(self, old_blocks, blocks);
+    self->size = blocks << self->min_shift;
+
+    if (DEBUG) {
+        printf(ANSI_COLOR_CYAN "[BUDDY] Grew arena to %zu bytes (%u shard(s) of order %d)\n"
+            ANSI_COLOR_RESET, self->size, self->shard_count, self->shard_order);
+    }
+    return 0;
+}
+
 void buddy_destroy(struct buddy *self)
 {
     if (self) {
-        if (self->tree) {
-            bt_destroy(self->tree);
+        for (size_t i = 0; i < self->chunk_count; i++) {
+            free(self->chunks[i]);
         }
+        for (unsigned s = 0; s < self->shard_count; s++) {
+            pthread_mutex_destroy(&self->shards[s].lock);
+            for (int order = 0; order <= self->shard_order; order++) {
+                destroy_bitmap(self->shards[s].free_area[order].map);
+            }
+        }
+        free(self->chunks);
+        free(self->shards);
         free(self);
     }
 }
@@ -187,41 +603,71 @@ size_t buddy_get_size(struct buddy *self)
     return self->size;
 }
 
-// Find a suitable block in the tree for allocation
-static bt_node_t* find_suitable_block(bt_node_t* node, size_t size)
+size_t buddy_get_min_block(struct buddy *self)
 {
-    if (!node) return NULL;
-    
-    buddy_node_data_t* data = (buddy_node_data_t*)node->data;
-    
-    // If this node is too small or already allocated, return NULL
-    if (data->longest_free < size) {
-        return NULL;
+    if (self == NULL) {
+        return 0;
     }
-    
-    // If this node is exactly the right size and free, return it
-    if (data->size == size && !data->is_allocated) {
-        return node;
+    return self->min_block;
+}
+
+size_t buddy_get_metadata_size(struct buddy *self)
+{
+    if (self == NULL) {
+        return 0;
     }
-    
-    // Try left subtree first
-    bt_node_t* left_result = NULL;
-    if (node->left) {
-        buddy_node_data_t* left_data = (buddy_node_data_t*)node->left->data;
-        if (left_data->longest_free >= size) {
-            left_result = find_suitable_block(node->left, size);
+    size_t bitmaps = 0;
+    for (unsigned s = 0; s < self->shard_count; s++) {
+        for (int order = 0; order <= self->shard_order; order++) {
+            bitmaps += bitmap_memory_size(self->shards[s].free_area[order].map);
         }
     }
-    
-    if (left_result) {
-        return left_result;
+    return sizeof(struct buddy)
+        + sizeof(buddy_shard_t) * self->shard_count
+        + bitmaps
+        + sizeof(buddy_block_t*) * self->chunk_count
+        + sizeof(buddy_block_t) * BUDDY_CHUNK_SIZE * __atomic_load_n(&self->chunks_used, __ATOMIC_RELAXED);
+}
+
+void buddy_get_stats(struct buddy *self, buddy_stats_t* stats)
+{
+    memset(stats, 0, sizeof(buddy_stats_t));
+    if (self == NULL) {
+        return;
     }
-    
-    // Try right subtree if left didn't work
-    return find_suitable_block(node->right, size);
+
+    lock_all(self);
+    unsigned free_shards = 0;   // Length of the current run of entirely free shards
+    for (unsigned s = 0; s < self->shard_count; s++) {
+        buddy_shard_t* shard = &self->shards[s];
+        stats->free_bytes += shard->free_units << self->min_shift;
+        for (int order = 0; order <= self->shard_order; order++) {
+            stats->free_blocks[order] += bitmap_count(shard->free_area[order].map);
+        }
+        if (shard->nonempty) {
+            size_t largest = self->min_block << (31 - __builtin_clz(shard->nonempty));
+            if (largest > stats->largest_free) {
+                stats->largest_free = largest;
+            }
+        }
+
+        // Aligned runs of entirely free shards can be claimed as one larger block
+        free_shards = (shard->nonempty & (1u << self->shard_order)) ? free_shards + 1 : 0;
+        if (free_shards > 1) {
+            unsigned span = 1u << (31 - __builtin_clz(free_shards));
+            while (span > 1 && (s + 1) % span != 0) {
+                span >>= 1;
+            }
+            size_t largest = (self->min_block << self->shard_order) * span;
+            if (largest > stats->largest_free) {
+                stats->largest_free = largest;
+            }
+        }
+    }
+    unlock_all(self);
 }
 
-int buddy_alloc(struct buddy *self, size_t size)
+static long alloc_blocks(struct buddy *self, size_t size, bool trim)
 {
     if (self == NULL) {
         if (DEBUG) {
@@ -229,114 +675,447 @@ int buddy_alloc(struct buddy *self, size_t size)
         }
         return -1;
     }
-    
+
     if (self->size < size) {
         if (DEBUG) {
-            printf(ANSI_COLOR_RED "[BUDDY] Cannot allocate: requested size %zu exceeds total memory %zu\n" 
+            printf(ANSI_COLOR_RED "[BUDDY] Cannot allocate: requested size %zu exceeds total memory %zu\n"
                 ANSI_COLOR_RESET, size, self->size);
         }
         return -1;
     }
-    
+
     // Ensure minimum size is at least 1
     if (size < 1) size = 1;
-    
-    size_t original_size = size;
-    size = next_power_of_2(size);
-    
+
+    uint32_t blocks = (size + self->min_block - 1) >> self->min_shift;
+    int order = order_of(blocks);
+    uint32_t need = trim ? blocks : 1u << order;
+
     if (DEBUG) {
-        printf(ANSI_COLOR_CYAN "[BUDDY] Attempting to allocate %zu units (rounded from %zu to power of 2)\n" 
-            ANSI_COLOR_RESET, size, original_size);
+        printf(ANSI_COLOR_CYAN "[BUDDY] Attempting to allocate %zu bytes (rounded from %zu%s)\n"
+            ANSI_COLOR_RESET, (size_t)need << self->min_shift, size,
+            trim ? " to min blocks" : " to power of 2");
+    }
+
+    uint32_t index = BUDDY_NONE;
+    if (order > self->shard_order) {
+        index = multi_shard_alloc(self, order, need);
+    } else {
+        if (shard_hint == UINT32_MAX) {
+            shard_hint = __atomic_fetch_add(&next_shard_hint, 1, __ATOMIC_RELAXED);
+        }
+        unsigned start = shard_hint & (self->shard_count - 1);
+
+        // Start at this thread's shard and move on while shards come up empty
+        for (unsigned i = 0; i < self->shard_count && index == BUDDY_NONE; i++) {
+            buddy_shard_t* shard = &self->shards[(start + i) & (self->shard_count - 1)];
+            if ((__atomic_load_n(&shard->nonempty, __ATOMIC_RELAXED) >> order) == 0) {
+                continue;
+            }
+            shard_lock(self, shard);
+            index = shard_alloc(self, shard, order, need);
+            shard_unlock(self, shard);
+        }
     }
-    
-    bt_node_t* node = find_suitable_block(self->tree->root, size);
-    if (!node) {
+
+    if (index == BUDDY_NONE) {
         if (DEBUG) {
-            printf(ANSI_COLOR_RED "[BUDDY] Failed to find suitable block for size %zu\n" 
-                ANSI_COLOR_RESET, size);
+            printf(ANSI_COLOR_RED "[BUDDY] Failed to find suitable block for size %zu\n"
+                ANSI_COLOR_RESET, self->min_block << order);
         }
         return -1;  // No suitable block found
     }
-    
-    buddy_node_data_t* data = (buddy_node_data_t*)node->data;
-    
-    // Mark this node as allocated
-    data->is_allocated = true;
-    data->longest_free = 0;
-    
-    // Update longest_free values up the tree
-    bt_node_t* current = node->parent;
-    while (current) {
-        update_longest_free(current);
-        current = current->parent;
-    }
-    
+
+    long offset = (long)index << self->min_shift;
+
     if (DEBUG) {
-        printf(ANSI_COLOR_CYAN "[BUDDY] Successfully allocated block at offset %d, size %zu\n" 
-            ANSI_COLOR_RESET, data->offset, data->size);
+        printf(ANSI_COLOR_CYAN "[BUDDY] Successfully allocated block at offset %ld, size %zu\n"
+            ANSI_COLOR_RESET, offset, (size_t)need << self->min_shift);
     }
-    
-    return data->offset;
+
+    return offset;
 }
 
-void buddy_free(struct buddy *self, int offset)
+long buddy_alloc(struct buddy *self, size_t size)
 {
-    if (self == NULL || offset < 0 || offset > self->size) {
-        return;
+    return alloc_blocks(self, size, false);
+}
+
+long buddy_alloc_trim(struct buddy *self, size_t size)
+{
+    return alloc_blocks(self, size, true);
+}
+
+size_t buddy_alloc_size(struct buddy *self, long offset)
+{
+    if (self == NULL || offset < 0 || (size_t)offset >= self->size || (offset & (self->min_block - 1))) {
+        return 0;
     }
-    
-    // Find the node representing this allocation
-    bt_node_t* node = self->tree->root;
-    size_t node_size = self->size;
-    
-    while (node) {
-        buddy_node_data_t* data = (buddy_node_data_t*)node->data;
-        
-        if (data->offset == offset && data->is_allocated) {
-            // Found the node, mark it as free
-            data->is_allocated = false;
-            data->pid = -1;
-            data->longest_free = data->size;
+
+    size_t blocks = 0;
+    uint32_t index = offset >> self->min_shift;
+    lock_all(self);
+    int order = peek_block(self, index)->order;
+    if (order != BUDDY_ORDER_NONE && !(order & BUDDY_EXTENT_PART)) {
+        for (;;) {
+            blocks += (size_t)1 << (order & BUDDY_ORDER_MASK);
+            if (!(order & BUDDY_EXTENT_MORE)) {
+                break;
+            }
+            index += 1u << (order & BUDDY_ORDER_MASK);
+            order = peek_block(self, index)->order;
+        }
+    }
+    unlock_all(self);
+    return blocks << self->min_shift;
+}
+
+int buddy_free(struct buddy *self, long offset)
+{
+    if (self == NULL || offset < 0 || (size_t)offset >= self->size || (offset & (self->min_block - 1))) {
+        if (DEBUG) {
+            printf(ANSI_COLOR_RED "[BUDDY] Cannot free: offset %ld is not a block in the arena\n"
+                ANSI_COLOR_RESET, offset);
+        }
+        return -1;
+    }
+
+    // Release every part of the allocation, one block at a time
+    uint32_t head = offset >> self->min_shift;
+    uint32_t next = head;
+    int record;
+    do {
+        uint32_t index = next;
+        buddy_shard_t* shard = shard_of(self, index);
+
+        shard_lock(self, shard);
+        record = peek_block(self, index)->order;
+        if (record == BUDDY_ORDER_NONE || (index == head && (record & BUDDY_EXTENT_PART))) {
+            shard_unlock(self, shard);
+            record = BUDDY_ORDER_NONE;
             break;
         }
-        
-        node_size /= 2;
-        if (offset < data->offset + node_size) {
-            node = node->left;
-        } else {
-            node = node->right;
-        }
-    }
-    
-    if (!node) {
-        return;  // Node not found
-    }
-    
-    // Try to merge with buddy if possible
-    bt_node_t* current = node->parent;
-    while (current) {
-        buddy_node_data_t* data = (buddy_node_data_t*)current->data;
-        buddy_node_data_t* left_data = (buddy_node_data_t*)current->left->data;
-        buddy_node_data_t* right_data = (buddy_node_data_t*)current->right->data;
-        
-        // Check if both children are free
-        if (!left_data->is_allocated && !right_data->is_allocated && 
-            left_data->longest_free == left_data->size && 
-            right_data->longest_free == right_data->size) {
-            data->longest_free = data->size;
+        int order = record & BUDDY_ORDER_MASK;
+        next = index + (1u << order);
+
+        if (order > self->shard_order) {
+            // Spans several shards: give each its whole block back under every lock
+            shard_unlock(self, shard);
+            lock_all(self);
+            if (peek_block(self, index)->order != record) {
+                unlock_all(self);
+                record = BUDDY_ORDER_NONE;
+                break;
+            }
+            touch_block(self, index)->order = BUDDY_ORDER_NONE;
+            uint32_t first = index >> self->shard_order;
+            uint32_t span = 1u << (order - self->shard_order);
+            for (uint32_t s = first; s < first + span; s++) {
+                free_area_push(self, &self->shards[s], self->shard_order, s << self->shard_order);
+            }
+            unlock_all(self);
+            continue;
+        }
+
+        touch_block(self, index)->order = BUDDY_ORDER_NONE;
+        release_block(self, shard, index, order);
+        shard_unlock(self, shard);
+    } while (record & BUDDY_EXTENT_MORE);
+
+    if (record == BUDDY_ORDER_NONE) {
+        if (DEBUG) {
+            printf(ANSI_COLOR_RED "[BUDDY] Cannot free: no allocated block at offset %ld (double free?)\n"
+                ANSI_COLOR_RESET, offset);
+        }
+        return -1;
+    }
+    return 0;
+}
+
+typedef struct batch_part {
+    uint32_t index;
+    int next;               // Next pending block of the same order, or -1
+} batch_part_t;
+
+int buddy_alloc_batch(struct buddy *self, const size_t sizes[], int n, long offsets[], bool trim)
+{
+    if (self == NULL || n <= 0) {
+        return 0;
+    }
+
+    // Counting sort by order, largest first and in submission order within an order
+    int start[BUDDY_MAX_ORDER + 2] = { 0 };
+    int* order_of_request = b_malloc(sizeof(int) * n * 2);
+    int* by_order = order_of_request + n;
+    for (int i = 0; i < n; i++) {
+        offsets[i] = -1;
+        size_t size = sizes[i] < 1 ? 1 : sizes[i];
+        order_of_request[i] = size > self->size ? -1 : order_of((size + self->min_block - 1) >> self->min_shift);
+        if (order_of_request[i] >= 0) {
+            start[BUDDY_MAX_ORDER - order_of_request[i] + 1]++;
+        }
+    }
+    for (int k = 1; k <= BUDDY_MAX_ORDER + 1; k++) {
+        start[k] += start[k - 1];
+    }
+    int queued = start[BUDDY_MAX_ORDER + 1];
+    for (int i = 0; i < n; i++) {
+        if (order_of_request[i] >= 0) {
+            by_order[start[BUDDY_MAX_ORDER - order_of_request[i]]++] = i;
+        }
+    }
+
+    if (shard_hint == UINT32_MAX) {
+        shard_hint = __atomic_fetch_add(&next_shard_hint, 1, __ATOMIC_RELAXED);
+    }
+    unsigned first_shard = shard_hint & (self->shard_count - 1);
+
+    // Place large requests before small ones split the blocks they need
+    int allocated = 0;
+    lock_all(self);
+    for (int q = 0; q < queued; q++) {
+        int i = by_order[q];
+        int order = order_of_request[i];
+        uint32_t need = trim ? (uint32_t)(((sizes[i] < 1 ? 1 : sizes[i]) + self->min_block - 1) >> self->min_shift)
+                             : 1u << order;
+        uint32_t index = BUDDY_NONE;
+
+        if (order > self->shard_order) {
+            index = claim_shards(self, order, need);
         } else {
-            data->longest_free = max(left_data->longest_free, right_data->longest_free);
+            for (unsigned k = 0; k < self->shard_count && index == BUDDY_NONE; k++) {
+                index = shard_alloc(self, &self->shards[(first_shard + k) & (self->shard_count - 1)], order, need);
+            }
+        }
+        if (index != BUDDY_NONE) {
+            offsets[i] = (long)index << self->min_shift;
+            allocated++;
+        }
+    }
+    unlock_all(self);
+    free(order_of_request);
+
+    if (DEBUG) {
+        printf(ANSI_COLOR_CYAN "[BUDDY] Batch allocated %d of %d request(s)\n" ANSI_COLOR_RESET, allocated, n);
+    }
+    return allocated;
+}
+
+int buddy_free_batch(struct buddy *self, const long offsets[], int n)
+{
+    if (self == NULL || n <= 0) {
+        return 0;
+    }
+
+    int rejected = 0;
+    int part_count = 0;
+    int part_capacity = 2 * n;
+    int pending[BUDDY_MAX_ORDER + 1];
+    batch_part_t* parts = b_malloc(sizeof(batch_part_t) * part_capacity);
+    for (int k = 0; k <= BUDDY_MAX_ORDER; k++) {
+        pending[k] = -1;
+    }
+
+    lock_all(self);
+
+    // Detach every part of every allocation and mark it pending at its order;
+    // a duplicate offset finds its record already cleared
+    for (int i = 0; i < n; i++) {
+        long offset = offsets[i];
+        if (offset < 0 || (size_t)offset >= self->size || (offset & (self->min_block - 1))) {
+            rejected++;
+            continue;
+        }
+        uint32_t index = offset >> self->min_shift;
+        int record = peek_block(self, index)->order;
+        if (record == BUDDY_ORDER_NONE || (record & BUDDY_EXTENT_PART)) {
+            rejected++;
+            continue;
+        }
+        for (;;) {
+            int order = record & BUDDY_ORDER_MASK;
+            buddy_block_t* block = touch_block(self, index);
+            block->order = BUDDY_ORDER_NONE;
+            if (order >= self->shard_order) {
+                uint32_t first = index >> self->shard_order;
+                for (uint32_t s = first; s < first + (1u << (order - self->shard_order)); s++) {
+                    free_area_push(self, &self->shards[s], self->shard_order, s << self->shard_order);
+                }
+            } else {
+                if (part_count == part_capacity) {
+                    part_capacity *= 2;
+                    parts = realloc(parts, sizeof(batch_part_t) * part_capacity);
+                    if (parts == NULL) {
+                        fprintf(stderr, "my_malloc: not enough memory, quit\n");
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                block->free_order = order | BUDDY_FREE_PENDING;
+                parts[part_count] = (batch_part_t){ index, pending[order] };
+                pending[order] = part_count++;
+            }
+            if (!(record & BUDDY_EXTENT_MORE)) {
+                break;
+            }
+            index += 1u << order;
+            record = peek_block(self, index)->order;
+        }
+    }
+
+    // Coalesce one order at a time: a pending block merges with a pending or published
+    // buddy and moves up, so intermediate blocks never reach the bitmaps
+    int published = 0;
+    for (int order = 0; order < self->shard_order; order++) {
+        for (int p = pending[order]; p != -1; p = parts[p].next) {
+            uint32_t index = parts[p].index;
+            buddy_block_t* block = touch_block(self, index);
+            if (block->free_order != (order | BUDDY_FREE_PENDING)) {
+                continue;   // Already absorbed by its buddy
+            }
+
+            uint32_t buddy = index ^ ((uint32_t)1 << order);
+            int buddy_order = peek_block(self, buddy)->free_order;
+            if (buddy_order == (order | BUDDY_FREE_PENDING)) {
+                touch_block(self, buddy)->free_order = BUDDY_ORDER_NONE;
+            } else if (buddy_order == order) {
+                free_area_remove(self, shard_of(self, buddy), order, buddy);
+            } else {
+                block->free_order = BUDDY_ORDER_NONE;
+                free_area_push(self, shard_of(self, index), order, index);
+                published++;
+                continue;
+            }
+
+            block->free_order = BUDDY_ORDER_NONE;
+            if (buddy < index) {
+                index = buddy;
+            }
+            if (order + 1 == self->shard_order) {
+                free_area_push(self, shard_of(self, index), order + 1, index);
+                published++;
+                continue;
+            }
+            if (part_count == part_capacity) {
+                part_capacity *= 2;
+                parts = realloc(parts, sizeof(batch_part_t) * part_capacity);
+                if (parts == NULL) {
+                    fprintf(stderr, "my_malloc: not enough memory, quit\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            touch_block(self, index)->free_order = (order + 1) | BUDDY_FREE_PENDING;
+            parts[part_count] = (batch_part_t){ index, pending[order + 1] };
+            pending[order + 1] = part_count++;
         }
-        
-        current = current->parent;
     }
+
+    unlock_all(self);
+    free(parts);
+
+    if (DEBUG) {
+        printf(ANSI_COLOR_CYAN "[BUDDY] Batch freed %d of %d allocation(s) as %d block(s)\n"
+            ANSI_COLOR_RESET, n - rejected, n, published);
+    }
+    return rejected ? -1 : 0;
 }
 
-static void print_node_data(void* data)
+int buddy_check(struct buddy *self)
 {
-    buddy_node_data_t* node_data = (buddy_node_data_t*)data;
-    printf("Offset: %d, Size: %zu, Longest: %zu, Allocated: %d\n", 
-           node_data->offset, node_data->size, node_data->longest_free, node_data->is_allocated);
+    if (self == NULL) {
+        return -1;
+    }
+
+    int errors = 0;
+    size_t free_blocks = 0;
+    lock_all(self);
+
+    // Allocated and free blocks must tile the arena exactly, each aligned to its size,
+    // and extent parts must follow the block that announced them
+    size_t block_count = (size_t)1 << self->max_order;
+    bool part_expected = false;
+    for (size_t index = 0; index < block_count;) {
+        const buddy_block_t* block = peek_block(self, index);
+        int order;
+
+        if (block->order != BUDDY_ORDER_NONE && block->free_order != BUDDY_ORDER_NONE) {
+            fprintf(stderr, "[BUDDY] check: block %zu is both allocated and free\n", index);
+            errors++;
+        }
+        if (block->free_order != BUDDY_ORDER_NONE) {
+            order = block->free_order;
+            free_blocks++;
+
+            // A free block whose buddy is free at the same order should have merged
+            uint32_t buddy = index ^ ((uint32_t)1 << order);
+            if (order < self->shard_order && peek_block(self, buddy)->free_order == order) {
+                fprintf(stderr, "[BUDDY] check: free buddies %zu and %u were not merged\n", index, buddy);
+                errors++;
+            }
+        } else if (block->order != BUDDY_ORDER_NONE) {
+            order = block->order & BUDDY_ORDER_MASK;
+        } else {
+            fprintf(stderr, "[BUDDY] check: no block starts at %zu\n", index);
+            errors++;
+            break;
+        }
+
+        bool is_part = block->order != BUDDY_ORDER_NONE && (block->order & BUDDY_EXTENT_PART);
+        if (is_part != part_expected) {
+            fprintf(stderr, "[BUDDY] check: extent chain broken at block %zu\n", index);
+            errors++;
+        }
+        part_expected = block->order != BUDDY_ORDER_NONE && (block->order & BUDDY_EXTENT_MORE);
+
+        if (index & (((size_t)1 << order) - 1)) {
+            fprintf(stderr, "[BUDDY] check: block %zu is not aligned to order %d\n", index, order);
+            errors++;
+        }
+        index += (size_t)1 << order;
+    }
+
+    // Every occupancy bit must agree with the records, the bit count, the order mask and
+    // the free unit counter
+    size_t listed = 0;
+    for (unsigned s = 0; s < self->shard_count; s++) {
+        buddy_shard_t* shard = &self->shards[s];
+        size_t units = 0;
+        for (int order = 0; order <= self->shard_order; order++) {
+            bitmap_t* map = shard->free_area[order].map;
+            size_t count = 0;
+            for (size_t bit = bitmap_find_first(map, 0); bit != BITMAP_NONE; bit = bitmap_find_first(map, bit + 1)) {
+                uint32_t index = ((uint32_t)s << self->shard_order) + ((uint32_t)bit << order);
+                if (peek_block(self, index)->free_order != order) {
+                    fprintf(stderr, "[BUDDY] check: shard %u order %d marks %u free but its record disagrees\n",
+                            s, order, index);
+                    errors++;
+                }
+                count++;
+            }
+            if (count != bitmap_count(map)) {
+                fprintf(stderr, "[BUDDY] check: shard %u order %d holds %zu blocks, expected %zu\n",
+                        s, order, count, bitmap_count(map));
+                errors++;
+            }
+            if (((shard->nonempty >> order) & 1) != (count > 0)) {
+                fprintf(stderr, "[BUDDY] check: shard %u order %d mask bit is stale\n", s, order);
+                errors++;
+            }
+            listed += count;
+            units += count << order;
+        }
+        if (units != shard->free_units) {
+            fprintf(stderr, "[BUDDY] check: shard %u counts %zu free min blocks, bitmaps hold %zu\n",
+                    s, shard->free_units, units);
+            errors++;
+        }
+    }
+    if (listed != free_blocks) {
+        fprintf(stderr, "[BUDDY] check: %zu free blocks in the arena but %zu in the bitmaps\n", free_blocks, listed);
+        errors++;
+    }
+
+    unlock_all(self);
+    return errors ? -1 : 0;
 }
 
 void buddy_dump(struct buddy *self)
@@ -347,32 +1126,27 @@ void buddy_dump(struct buddy *self)
     }
 
     printf("Buddy System Dump:\n");
-    printf("Total size: %zu\n", self->size);
-    
-    if (!self->tree) {
-        printf("Tree is NULL!\n");
-        return;
-    }
-    
-    if (!self->tree->root) {
-        printf("Tree root is NULL!\n");
-        return;
-    }
+    printf("Total size: %zu bytes, min block: %zu bytes, %u shard(s)\n",
+           self->size, self->min_block, self->shard_count);
+    printf("Metadata: %zu bytes (%zu of %zu chunks materialized)\n",
+           buddy_get_metadata_size(self), self->chunks_used, self->chunk_count);
 
-    printf("Tree structure:\n");
-    
-    // Print the root node details first
-    buddy_node_data_t* root_data = (buddy_node_data_t*)self->tree->root->data;
-    printf("Root node - Offset: %d, Size: %zu, Longest free: %zu, Allocated: %d\n", 
-           root_data->offset, root_data->size, root_data->longest_free, root_data->is_allocated);
-    
-    // Print tree in level order
-    int height = bt_height(self->tree->root);
-    printf("Tree height: %d\n", height);
-    
-    for (int level = 0; level <= height; level++) {
-        printf("Level %d: ", level);
-        bt_preorder_traverse(self->tree, self->tree->root, print_node_data);
-        printf("\n");
-    }
-}
\ No newline at end of file
+    lock_all(self);
+    printf("Free areas:\n");
+    for (unsigned s = 0; s < self->shard_count; s++) {
+        for (int order = 0; order <= self->shard_order; order++) {
+            bitmap_t* map = self->shards[s].free_area[order].map;
+            if (bitmap_count(map) == 0) {
+                continue;
+            }
+            printf("  Shard %u order %d (size %zu): %zu free block(s):", s, order, self->min_block << order,
+                   bitmap_count(map));
+            for (size_t bit = bitmap_find_first(map, 0); bit != BITMAP_NONE; bit = bitmap_find_first(map, bit + 1)) {
+                uint32_t index = ((uint32_t)s << self->shard_order) + ((uint32_t)bit << order);
+                printf(" %ld", (long)index << self->min_shift);
+            }
+            printf("\n");
+        }
+    }
+    unlock_all(self);
+}
@@ -2,14 +2,50 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 
 struct buddy;
 
-struct buddy *buddy_new(unsigned num_of_fragments);
-int buddy_alloc(struct buddy *self, size_t size);
-void buddy_free(struct buddy *self, int offset);
+#define BUDDY_STATS_ORDERS 32
+
+typedef struct buddy_stats {
+    size_t free_bytes;                          // Bytes held by free blocks
+    size_t largest_free;                        // Largest block an allocation could get right now
+    size_t free_blocks[BUDDY_STATS_ORDERS];     // Free blocks of min_block << k bytes
+} buddy_stats_t;
+
+// arena_size and min_block are in bytes and must both be powers of 2
+struct buddy *buddy_new(size_t arena_size, size_t min_block);
+// Thread-safe variant: the arena is split into `shards` (a power of 2) independently locked subtrees
+struct buddy *buddy_new_concurrent(size_t arena_size, size_t min_block, unsigned shards);
+long buddy_alloc(struct buddy *self, size_t size);
+// Like buddy_alloc, but only the min blocks the request needs stay allocated; the rest of
+// the power-of-2 block is returned to the free lists
+long buddy_alloc_trim(struct buddy *self, size_t size);
+// Bytes actually reserved by the allocation at offset (0 if none starts there)
+size_t buddy_alloc_size(struct buddy *self, long offset);
+// Returns 0 on success, -1 if no allocated block starts at offset (invalid offset or double free)
+int buddy_free(struct buddy *self, long offset);
+// Allocate n requests at once, largest first; offsets[i] is -1 for a request that did not fit.
+// Returns how many were allocated
+int buddy_alloc_batch(struct buddy *self, const size_t sizes[], int n, long offsets[], bool trim);
+// Free n allocations at once, coalescing them together; returns 0 if all were freed,
+// -1 if any offset was rejected (the valid ones are still freed)
+int buddy_free_batch(struct buddy *self, const long offsets[], int n);
 void buddy_dump(struct buddy *self);
+// Verify free lists, order records and block tiling; returns 0 if consistent, -1 otherwise
+int buddy_check(struct buddy *self);
 void buddy_destroy(struct buddy *self);
+// Grow the arena to new_size bytes, keeping every offset; the old tree becomes the left half
+// of a doubled root, or with independent_roots the new space is added as separate roots that
+// never merge with it. Must not run concurrently with other calls. Returns 0 or -1
+int buddy_grow(struct buddy *self, size_t new_size, bool independent_roots);
 
 // Add a new function to get the buddy system's total memory size
 size_t buddy_get_size(struct buddy *self);
+size_t buddy_get_min_block(struct buddy *self);
+// Free space counters; maintained as blocks move in and out of the free bitmaps, so this
+// only sums them per shard
+void buddy_get_stats(struct buddy *self, buddy_stats_t* stats);
+// Bytes of bookkeeping currently held, including lazily materialized chunks
+size_t buddy_get_metadata_size(struct buddy *self);
@@ -21,6 +21,9 @@
 #define ANSI_COLOR_BOLD_CYAN "\x1b[1;36m"
 #define ANSI_COLOR_BOLD_WHITE "\x1b[1;37m"
 
+// Builds that cannot afford per-operation tracing (the stress harness) pass -DDEBUG=0
+#ifndef DEBUG
 #define DEBUG 1
+#endif
 
 #endif  // COLORS_H
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stddef.h>
+
 // Message structure for IPC
 typedef struct
 {
@@ -19,7 +21,19 @@ typedef struct
     int waiting_time;
 } finishedProcessInfo;
 
-#define MAX_INPUT_PROCESSES 100
+// One tick's view of simulated memory, sampled by the scheduler
+typedef struct
+{
+    int time;
+    float external_fragmentation; // 1 - largest free block / free memory
+    float internal_fragmentation; // Share of reserved memory no process asked for
+    size_t free_bytes;
+    size_t largest_free;
+    int waiting;                  // Processes waiting for memory
+} memorySample;
+
+// Initial capacity of the growable per-process tables; it does not cap anything
+#define INITIAL_PROCESS_CAPACITY 128
 
 
 // Constants
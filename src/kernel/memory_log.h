@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * memory.bin: a header followed by fixed-size event records, in the order the memory
+ * manager logged them. `memlog` renders it as the memory.log text format.
+ */
+#define MEMORY_LOG_FILE "memory.bin"
+#define MEMORY_LOG_MAGIC "MEMLOG\0"
+#define MEMORY_LOG_VERSION 1
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;       // sizeof(memory_event_t), checked by readers
+} memory_log_header_t;
+
+typedef enum {
+    MEMORY_EVENT_ALLOC,
+    MEMORY_EVENT_FREE,
+    MEMORY_EVENT_GROW,          // offset holds the old memory size, reserved the new one
+    MEMORY_EVENT_SWAP_OUT,
+    MEMORY_EVENT_SWAP_IN,
+} memory_event_op_t;
+
+typedef struct {
+    int32_t tick;
+    int32_t id;                 // Process ID
+    uint8_t op;                 // memory_event_op_t
+    uint8_t order;              // Allocations: log2 of the reserved block in min blocks, rounded up
+    uint16_t unused;
+    uint32_t size;              // Bytes the process asked for
+    int64_t offset;
+    uint64_t reserved;          // Allocations: bytes the allocator set aside
+} memory_event_t;
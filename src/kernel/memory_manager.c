@@ -1,247 +1,359 @@
 #include "memory_manager.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
 #include "colors.h"
-#include "buddy.h"
+#include "allocator.h"
+#include "shared_mem.h"
+#include "memory_log.h"
+#include "../data_structures/proc_map.h"
 
+#define MM_WAIT_CLASSES 64
+
+typedef struct waiting_process {
+    processParameters params;
+    size_t size;
+    long seq;                 // Order it joined the waiting list in
+    struct waiting_process* next;
+} waiting_process_t;
+
+// Memory held for a process between admission and fork
 typedef struct {
-    struct buddy* memory;
-    min_heap_t* waiting_list;
-    int* id_to_offset_map;    // Map process ID to memory offset
-    size_t* id_to_size_map;   // Map process ID to memory size
-    int max_id;               // Max process ID
-    
-    // Fields for PID-to-ID mapping
-    int* pid_to_id_map;       // Maps PIDs to process IDs
-    int* id_to_pid_map;       // Maps process IDs to PIDs
-    int max_pid;              // Maximum PID value
-} memory_manager_t;
+    long offset;              // -1 while the slot is unused
+    size_t size;
+    int next_free;            // Next unused slot, -1 at the end of the list
+} reservation_t;
 
-static memory_manager_t* mm = NULL;
+// When a live allocation is projected to give its bytes back
+typedef struct {
+    int tick;
+    size_t bytes;
+} projected_release_t;
 
 typedef struct {
-    processParameters params;        
-    size_t size;   
-} waiting_process_t;
+    allocator_t* memory;
 
-// Comparator For Min Heap
-static int waiting_process_compare(const void* a, const void* b) {
-    const waiting_process_t* wa = (const waiting_process_t*)a;
-    const waiting_process_t* wb = (const waiting_process_t*)b;
-    
-    // Compare based on memory size (smaller sizes get higher priority)
-    if (wa->size != wb->size) {
-        return wa->size < wb->size ? -1 : 1;
-    }
-    
-    // If sizes are equal, compare based on arrival time
-    return wa->params.arrival_time - wb->params.arrival_time;
-}
+    // Waiting list, bucketed by rounded allocation order (log2 of the size in min blocks,
+    // rounded up); each bucket is FIFO
+    waiting_process_t* waiting_head[MM_WAIT_CLASSES];
+    waiting_process_t* waiting_tail[MM_WAIT_CLASSES];
+    uint64_t waiting_classes;  // Bit k set while bucket k is not empty
+    int waiting_count;
+    long waiting_seq;          // Next waiting_process_t::seq
+    admission_policy_t admission;
+    int release_horizon;       // Projected tick all admitted work is done
 
-// Global variable for memory log file
-static FILE* memory_log_file = NULL;
+    proc_map_t* procs;        // Offset, size and PID of each process ID, indexed by PID too
 
-// Helper function declarations
-static inline bool is_power_of_2(unsigned int x) {
-    return (x != 0) && ((x & (x - 1)) == 0);
+    unsigned alloc_flags;     // ALLOC_TRIM returns the unused tail of each rounded block
+
+    size_t requested_bytes;   // Sum of the sizes live allocations asked for
+    int allocations;          // Live allocations, including reservations
+    reservation_t* reservations;  // Indexed by token
+    int reservation_capacity;
+    int free_reservation;     // First unused slot, -1 if all are taken
+    projected_release_t* releases;  // Backfill scratch, kept between admissions
+    int release_capacity;
+    memory_stats_t* stats;    // Counters shared with the scheduler (NULL if unavailable)
+} memory_manager_t;
+
+static memory_manager_t* mm = NULL;
+
+// Waiting-list bucket of a request
+static int size_class(size_t size) {
+    size_t blocks = (size + mm->memory->min_block - 1) / mm->memory->min_block;
+    return blocks <= 1 ? 0 : 64 - __builtin_clzl(blocks - 1);
 }
 
-static inline unsigned int next_power_of_2(unsigned int x) {
-    x--;
-    x |= x >> 1;
-    x |= x >> 2;
-    x |= x >> 4;
-    x |= x >> 8;
-    x |= x >> 16;
-    x++;
-    return x;
+// Refresh the counters the scheduler samples every tick
+static void publish_stats() {
+    if (mm->stats == NULL) {
+        return;
+    }
+    allocator_stats_t alloc_stats;
+    allocator_stats(mm->memory, &alloc_stats);
+    mm->stats->total_bytes = alloc_stats.total_bytes;
+    mm->stats->free_bytes = alloc_stats.free_bytes;
+    mm->stats->largest_free = alloc_stats.largest_free;
+    mm->stats->requested_bytes = mm->requested_bytes;
+    mm->stats->allocations = mm->allocations;
+    mm->stats->waiting = mm->waiting_count;
+
+    int arenas = allocator_arena_count(mm->memory);
+    mm->stats->arena_count = arenas;
+    for (int k = 0; k < arenas; k++) {
+        arena_stats_t arena;
+        allocator_arena_stats(mm->memory, k, &arena);
+        mm->stats->arenas[k].total_bytes = arena.memory.total_bytes;
+        mm->stats->arenas[k].free_bytes = arena.memory.free_bytes;
+        mm->stats->arenas[k].peak_used = arena.peak_used;
+        mm->stats->arenas[k].placed = arena.placed;
+        mm->stats->arenas[k].spilled = arena.spilled;
+    }
 }
 
+// Memory events are appended to a buffer as binary records and written out once per
+// tick, or sooner if it fills up; `memlog` renders them as text offline
+#define MEMORY_LOG_BUFFER 4096
+
+static FILE* memory_log_file = NULL;
+static memory_event_t memory_log_buffer[MEMORY_LOG_BUFFER];
+static int memory_log_count = 0;
+
 void mm_initialize_memory_log()
 {
-    memory_log_file = fopen("memory.log", "w");
+    memory_log_file = fopen(MEMORY_LOG_FILE, "wb");
     if (memory_log_file == NULL)
     {
         perror("Failed to open memory log file");
         return;
     }
-    
-    fprintf(memory_log_file, "#At time x allocated y bytes for process z from i to j\n");
+
+    memory_log_header_t header = {MEMORY_LOG_MAGIC, MEMORY_LOG_VERSION, sizeof(memory_event_t)};
+    fwrite(&header, sizeof(header), 1, memory_log_file);
     fflush(memory_log_file);
 }
 
-void mm_log_memory_allocation(int time, int process_id, int size, int start_address, int end_address)
+void mm_flush_memory_log()
 {
-    if (memory_log_file == NULL)
+    if (memory_log_file == NULL || memory_log_count == 0)
         return;
-        
-    fprintf(memory_log_file, "At time %d allocated %d bytes for process %d from %d to %d\n",
-            time, size, process_id, start_address, end_address);
+
+    if (fwrite(memory_log_buffer, sizeof(memory_event_t), memory_log_count, memory_log_file) != (size_t)memory_log_count)
+        perror("Failed to write memory log");
     fflush(memory_log_file);
-    
-    if (DEBUG)
-        printf(ANSI_COLOR_BLUE"[MEMORY] At time %d allocated %d bytes for process %d from %d to %d\n"ANSI_COLOR_RESET,
-            time, size, process_id, start_address, end_address);
+    memory_log_count = 0;
 }
 
-void mm_log_memory_deallocation(int time, int process_id, int size, int start_address, int end_address)
+static void log_memory_event(int time, memory_event_op_t op, int process_id, int size, long offset, size_t reserved)
 {
     if (memory_log_file == NULL)
         return;
-        
-    fprintf(memory_log_file, "At time %d freed %d bytes from process %d from %d to %d\n",
-            time, size, process_id, start_address, end_address);
-    fflush(memory_log_file);
-    
+
+    if (memory_log_count == MEMORY_LOG_BUFFER)
+        mm_flush_memory_log();
+    memory_event_t* event = &memory_log_buffer[memory_log_count++];
+    event->tick = time;
+    event->id = process_id;
+    event->op = op;
+    event->order = (op == MEMORY_EVENT_ALLOC && mm != NULL) ? size_class(reserved) : 0;
+    event->unused = 0;
+    event->size = size;
+    event->offset = offset;
+    event->reserved = reserved;
+}
+
+void mm_log_memory_allocation(int time, int process_id, int size, long start_address, long end_address,
+                              size_t reserved)
+{
+    log_memory_event(time, MEMORY_EVENT_ALLOC, process_id, size, start_address, reserved);
+
     if (DEBUG)
-        printf(ANSI_COLOR_BLUE"[MEMORY] At time %d freed %d bytes from process %d from %d to %d\n"ANSI_COLOR_RESET,
+        printf(ANSI_COLOR_BLUE"[MEMORY] At time %d allocated %d bytes for process %d from %ld to %ld (internal fragmentation %zu bytes)\n"ANSI_COLOR_RESET,
+            time, size, process_id, start_address, end_address, reserved - size);
+}
+
+void mm_log_memory_deallocation(int time, int process_id, int size, long start_address, long end_address)
+{
+    log_memory_event(time, MEMORY_EVENT_FREE, process_id, size, start_address, 0);
+
+    if (DEBUG)
+        printf(ANSI_COLOR_BLUE"[MEMORY] At time %d freed %d bytes from process %d from %ld to %ld\n"ANSI_COLOR_RESET,
             time, size, process_id, start_address, end_address);
 }
 
+void mm_log_memory_growth(int time, size_t old_size, size_t new_size)
+{
+    log_memory_event(time, MEMORY_EVENT_GROW, -1, 0, old_size, new_size);
+
+    if (DEBUG)
+        printf(ANSI_COLOR_BLUE"[MEMORY] At time %d grew memory from %zu to %zu bytes\n"ANSI_COLOR_RESET,
+            time, old_size, new_size);
+}
+
+void mm_log_memory_swap(int time, int process_id, int size, long start_address, long end_address, bool swap_in)
+{
+    log_memory_event(time, swap_in ? MEMORY_EVENT_SWAP_IN : MEMORY_EVENT_SWAP_OUT, process_id, size, start_address, 0);
+
+    if (DEBUG)
+        printf(ANSI_COLOR_BLUE"[MEMORY] At time %d swapped %s %d bytes of process %d from %ld to %ld\n"ANSI_COLOR_RESET,
+            time, swap_in ? "in" : "out", size, process_id, start_address, end_address);
+}
+
 void mm_close_memory_log()
 {
     if (memory_log_file != NULL)
     {
+        mm_flush_memory_log();
         fclose(memory_log_file);
         memory_log_file = NULL;
     }
 }
 
-bool mm_init(unsigned int memory_size) {
+// Everything but the allocator, which the caller creates; takes ownership of memory
+static bool mm_setup(allocator_t* memory) {
     if (mm != NULL) {
         if (DEBUG) {
             printf(ANSI_COLOR_RED "[MEMORY MANAGER] Already initialized!\n" ANSI_COLOR_RESET);
         }
+        destroy_allocator(memory);
         return false;
     }
     
-    // Ensure memory size is a power of 2
-    if (!is_power_of_2(memory_size)) {
-        memory_size = next_power_of_2(memory_size);
-        if (DEBUG) {
-            printf(ANSI_COLOR_YELLOW "[MEMORY MANAGER] Adjusted memory size to %u (power of 2)\n" 
-                ANSI_COLOR_RESET, memory_size);
-        }
-    }
-    
     mm = malloc(sizeof(memory_manager_t));
     if (!mm) {
         if (DEBUG) {
             perror(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to allocate memory manager" ANSI_COLOR_RESET);
         }
+        destroy_allocator(memory);
         return false;
     }
+    mm->memory = memory;
     
-    // Initialize buddy system
-    mm->memory = buddy_new(memory_size);
-    if (mm->memory == NULL) {
+    // Initialize waiting list buckets
+    for (int k = 0; k < MM_WAIT_CLASSES; k++) {
+        mm->waiting_head[k] = NULL;
+        mm->waiting_tail[k] = NULL;
+    }
+    mm->waiting_classes = 0;
+    mm->waiting_count = 0;
+    mm->waiting_seq = 0;
+    mm->admission = ADMIT_SMALLEST_FIRST;
+    mm->release_horizon = 0;
+    
+    // Records exist only for live processes, so this grows with the workload, not the IDs
+    mm->procs = create_proc_map(64);
+    if (mm->procs == NULL) {
         if (DEBUG) {
-            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to initialize buddy system\n" ANSI_COLOR_RESET);
+            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to initialize process map\n" ANSI_COLOR_RESET);
         }
+        destroy_allocator(mm->memory);
         free(mm);
         mm = NULL;
         return false;
     }
     
-    // Initialize waiting list as min heap
-    mm->waiting_list = create_min_heap(MAX_INPUT_PROCESSES, waiting_process_compare);
-    if (mm->waiting_list == NULL) {
+    mm->alloc_flags = 0;
+    mm->reservations = NULL;
+    mm->reservation_capacity = 0;
+    mm->releases = NULL;
+    mm->release_capacity = 0;
+    mm->free_reservation = -1;
+    mm->requested_bytes = 0;
+    mm->allocations = 0;
+    mm->stats = attach_memory_stats(MEMORY_STATS_SHM_KEY);
+    publish_stats();
+
+    // Initialize memory log
+    mm_initialize_memory_log();
+    
+    return true;
+}
+
+// Every policy takes any size, but only in whole minimum blocks
+static size_t whole_blocks(size_t memory_size, size_t min_block) {
+    if (memory_size % min_block) {
+        memory_size -= memory_size % min_block;
         if (DEBUG) {
-            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to initialize waiting list\n" ANSI_COLOR_RESET);
+            printf(ANSI_COLOR_YELLOW "[MEMORY MANAGER] Adjusted memory size to %zu (whole minimum blocks)\n" 
+                ANSI_COLOR_RESET, memory_size);
         }
-        buddy_destroy(mm->memory);
-        free(mm);
-        mm = NULL;
-        return false;
     }
+    return memory_size < min_block ? min_block : memory_size;
+}
+
+bool mm_init(size_t memory_size, size_t min_block, alloc_policy_t policy) {
+    memory_size = whole_blocks(memory_size, min_block);
     
-    // Initialize process ID to offset map
-    mm->max_id = 1000; // Assume max 1000 process IDs
-    mm->id_to_offset_map = malloc(sizeof(int) * (mm->max_id + 1));
-    if (mm->id_to_offset_map == NULL) {
+    // Initialize the allocator for the chosen policy
+    allocator_t* memory = create_allocator(policy, memory_size, min_block);
+    if (memory == NULL) {
         if (DEBUG) {
-            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to initialize ID to offset map\n" ANSI_COLOR_RESET);
+            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to initialize %s allocator\n" ANSI_COLOR_RESET,
+                alloc_policy_name(policy));
         }
-        destroy_min_heap(mm->waiting_list);
-        buddy_destroy(mm->memory);
-        free(mm);
-        mm = NULL;
+        return false;
+    }
+    if (!mm_setup(memory)) {
         return false;
     }
     
-    // Initialize all offsets to -1 (not allocated)
-    for (int i = 0; i <= mm->max_id; i++) {
-        mm->id_to_offset_map[i] = -1;
+    if (DEBUG) {
+        printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Initialized %s with %zu bytes (min block %zu, %zu bytes of metadata)\n"
+            ANSI_COLOR_RESET, alloc_policy_name(policy), memory_size, min_block, allocator_metadata_size(mm->memory));
     }
     
-    // Initialize ID to size map
-    mm->id_to_size_map = malloc(sizeof(size_t) * (mm->max_id + 1));
-    if (mm->id_to_size_map == NULL) {
+    return true;
+}
+
+bool mm_init_arenas(const arena_spec_t specs[], int count, size_t min_block, placement_policy_t placement,
+                    bool locked) {
+    if (count < 1 || count > MAX_ARENAS) {
         if (DEBUG) {
-            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to initialize ID to size map\n" ANSI_COLOR_RESET);
+            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Need 1 to %d arenas, got %d\n" ANSI_COLOR_RESET,
+                MAX_ARENAS, count);
         }
-        free(mm->id_to_offset_map);
-        destroy_min_heap(mm->waiting_list);
-        buddy_destroy(mm->memory);
-        free(mm);
-        mm = NULL;
         return false;
     }
-    
-    // Initialize all sizes to 0 (not allocated)
-    for (int i = 0; i <= mm->max_id; i++) {
-        mm->id_to_size_map[i] = 0;
+    arena_spec_t adjusted[MAX_ARENAS];
+    for (int k = 0; k < count; k++) {
+        adjusted[k].size = whole_blocks(specs[k].size, min_block);
+        adjusted[k].policy = specs[k].policy;
     }
-    
-    // Initialize PID to ID mapping
-    mm->max_pid = 10000; // Assume max 10000 PIDs (larger than process IDs)
-    mm->pid_to_id_map = malloc(sizeof(int) * (mm->max_pid + 1));
-    if (mm->pid_to_id_map == NULL) {
+
+    allocator_t* memory = create_arena_allocator(adjusted, count, min_block, placement, locked);
+    if (memory == NULL) {
         if (DEBUG) {
-            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to initialize PID to ID map\n" ANSI_COLOR_RESET);
+            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to initialize %d arenas\n" ANSI_COLOR_RESET, count);
         }
-        free(mm->id_to_size_map);
-        free(mm->id_to_offset_map);
-        destroy_min_heap(mm->waiting_list);
-        buddy_destroy(mm->memory);
-        free(mm);
-        mm = NULL;
         return false;
     }
-    
-    // Initialize all mappings to -1 (no mapping)
-    for (int i = 0; i <= mm->max_pid; i++) {
-        mm->pid_to_id_map[i] = -1;
+    if (!mm_setup(memory)) {
+        return false;
     }
-    
-    // Initialize ID to PID mapping
-    mm->id_to_pid_map = malloc(sizeof(int) * (mm->max_id + 1));
-    if (mm->id_to_pid_map == NULL) {
-        if (DEBUG) {
-            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to initialize ID to PID map\n" ANSI_COLOR_RESET);
+
+    if (DEBUG) {
+        for (int k = 0; k < count; k++) {
+            printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Arena %d: %s with %zu bytes\n" ANSI_COLOR_RESET,
+                k, alloc_policy_name(adjusted[k].policy), adjusted[k].size);
         }
-        free(mm->pid_to_id_map);
-        free(mm->id_to_size_map);
-        free(mm->id_to_offset_map);
-        destroy_min_heap(mm->waiting_list);
-        buddy_destroy(mm->memory);
-        free(mm);
-        mm = NULL;
+        printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Initialized %d arenas, %s placement (min block %zu, %zu bytes of metadata)\n"
+            ANSI_COLOR_RESET, count, placement_policy_name(placement), min_block, allocator_metadata_size(mm->memory));
+    }
+    return true;
+}
+
+void mm_set_trim(bool enabled) {
+    if (mm != NULL) {
+        mm->alloc_flags = enabled ? ALLOC_TRIM : 0;
+    }
+}
+
+bool mm_grow(size_t new_size, bool independent_roots) {
+    if (mm == NULL) {
         return false;
     }
-    
-    // Initialize all mappings to -1 (no mapping)
-    for (int i = 0; i <= mm->max_id; i++) {
-        mm->id_to_pid_map[i] = -1;
+
+    // Only whole minimum blocks are usable, as in mm_init
+    allocator_stats_t alloc_stats;
+    allocator_stats(mm->memory, &alloc_stats);
+    size_t old_size = alloc_stats.total_bytes;
+    new_size -= new_size % mm->memory->min_block;
+    if (allocator_grow(mm->memory, new_size, independent_roots) == -1) {
+        if (DEBUG) {
+            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Cannot grow memory from %zu to %zu bytes\n"
+                ANSI_COLOR_RESET, old_size, new_size);
+        }
+        return false;
     }
-    
-    // Initialize memory log
-    mm_initialize_memory_log();
-    
+
+    mm_log_memory_growth(get_clk(), old_size, new_size);
+    publish_stats();
     if (DEBUG) {
-        printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Initialized with %u memory units\n" ANSI_COLOR_RESET, memory_size);
+        printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Grew memory to %zu bytes (%s)\n" ANSI_COLOR_RESET,
+            new_size, independent_roots ? "independent roots" : "doubled root");
     }
-    
     return true;
 }
 
@@ -250,32 +362,29 @@ void mm_destroy() {
         return;
     }
     
-    // Clean up buddy system
-    buddy_destroy(mm->memory);
+    // Clean up the allocator
+    destroy_allocator(mm->memory);
     
     // Clean up waiting list
-    if (mm->waiting_list != NULL) {
-        while (!min_heap_is_empty(mm->waiting_list)) {
-            waiting_process_t* process = min_heap_extract_min(mm->waiting_list);
+    for (int k = 0; k < MM_WAIT_CLASSES; k++) {
+        while (mm->waiting_head[k] != NULL) {
+            waiting_process_t* process = mm->waiting_head[k];
+            mm->waiting_head[k] = process->next;
             free(process);
         }
-        destroy_min_heap(mm->waiting_list);
     }
     
-    // Clean up ID to offset map
-    free(mm->id_to_offset_map);
-    
-    // Clean up ID to size map
-    free(mm->id_to_size_map);
-    
-    // Clean up PID to ID map
-    free(mm->pid_to_id_map);
-    
-    // Clean up ID to PID map
-    free(mm->id_to_pid_map);
+    // Outstanding reservations go away with the allocator
+    free(mm->reservations);
+    free(mm->releases);
+
+    // Clean up the process records and their PID index
+    destroy_proc_map(mm->procs);
     
     // Close memory log
     mm_close_memory_log();
+
+    detach_memory_stats(mm->stats);
     
     // Clean up memory manager
     free(mm);
@@ -286,68 +395,45 @@ void mm_destroy() {
     }
 }
 
+// Forget a process's memory; the record goes too unless a PID is still bound to it
+static void clear_allocation(proc_record_t* record) {
+    if (record->pid == -1) {
+        proc_map_remove(mm->procs, record->id);
+    } else {
+        record->offset = -1;
+        record->size = 0;
+    }
+}
+
+// Record a new allocation, or give it back if there is no memory for the record
+static bool record_allocation(int process_id, long offset, size_t size) {
+    proc_record_t* record = proc_map_put(mm->procs, process_id);
+    if (record == NULL) {
+        if (DEBUG) {
+            printf(ANSI_COLOR_RED "[MEMORY MANAGER] No room to record process ID %d\n" ANSI_COLOR_RESET, process_id);
+        }
+        allocator_free(mm->memory, offset);
+        return false;
+    }
+    record->offset = offset;
+    record->size = size;
+    return true;
+}
+
 // Map a PID to a process ID
 bool mm_map_pid_to_id(int pid, int process_id) {
     if (mm == NULL || pid < 0 || process_id < 0) {
         return false;
     }
     
-    // Expand PID map if needed
-    if (pid > mm->max_pid) {
-        int new_max_pid = pid + 1000; // Add some buffer
-        int* new_pid_map = realloc(mm->pid_to_id_map, sizeof(int) * (new_max_pid + 1));
-        if (!new_pid_map) {
-            if (DEBUG) {
-                printf(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to reallocate PID to ID map\n" ANSI_COLOR_RESET);
-            }
-            return false;
-        }
-        
-        // Initialize new entries to -1
-        for (int i = mm->max_pid + 1; i <= new_max_pid; i++) {
-            new_pid_map[i] = -1;
-        }
-        
-        mm->pid_to_id_map = new_pid_map;
-        mm->max_pid = new_max_pid;
-    }
-    
-    // Expand ID map if needed
-    if (process_id > mm->max_id) {
-        int new_max_id = process_id + 100;
-        int* new_offset_map = realloc(mm->id_to_offset_map, sizeof(int) * (new_max_id + 1));
-        if (!new_offset_map) return false;
-        for (int i = mm->max_id + 1; i <= new_max_id; i++) new_offset_map[i] = -1;
-        mm->id_to_offset_map = new_offset_map;
-        
-        size_t* new_size_map = realloc(mm->id_to_size_map, sizeof(size_t) * (new_max_id + 1));
-        if (!new_size_map) return false;
-        for (int i = mm->max_id + 1; i <= new_max_id; i++) new_size_map[i] = 0;
-        mm->id_to_size_map = new_size_map;
-        
-        int* new_id_to_pid_map = realloc(mm->id_to_pid_map, sizeof(int) * (new_max_id + 1));
-        if (!new_id_to_pid_map) return false;
-        for (int i = mm->max_id + 1; i <= new_max_id; i++) new_id_to_pid_map[i] = -1;
-        mm->id_to_pid_map = new_id_to_pid_map;
-        
-        mm->max_id = new_max_id;
-    }
-    
-    // Clear any existing mapping for this PID
-    int old_process_id = mm->pid_to_id_map[pid];
-    if (old_process_id != -1) {
-        mm->id_to_pid_map[old_process_id] = -1;
-    }
-    
-    // Clear any existing mapping for this process ID
-    int old_pid = mm->id_to_pid_map[process_id];
-    if (old_pid != -1) {
-        mm->pid_to_id_map[old_pid] = -1;
-    }
-    
-    // Store the bidirectional mapping
-    mm->pid_to_id_map[pid] = process_id;
-    mm->id_to_pid_map[process_id] = pid;
+    // Any previous mapping of either side is cleared
+    if (!proc_map_bind_pid(mm->procs, process_id, pid)) {
+        if (DEBUG) {
+            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to map PID %d to process ID %d\n" ANSI_COLOR_RESET,
+                pid, process_id);
+        }
+        return false;
+    }
     
     if (DEBUG) {
         printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Mapped PID %d to process ID %d\n" 
@@ -359,45 +445,27 @@ bool mm_map_pid_to_id(int pid, int process_id) {
 
 // Get process ID from PID (returns -1 if not found)
 int mm_get_id_by_pid(int pid) {
-    if (mm == NULL || pid < 0 || pid > mm->max_pid) {
+    if (mm == NULL || pid < 0) {
         return -1;
     }
     
-    return mm->pid_to_id_map[pid];
+    return proc_map_id_of(mm->procs, pid);
 }
 
 // Implementation for mm_map_id_to_pid
 bool mm_map_id_to_pid(int process_id, int pid) {
-    if (mm == NULL || process_id < 0 || process_id > mm->max_id || pid < 0) {
+    if (mm == NULL || process_id < 0 || pid < 0) {
         return false;
     }
     
-    // Expand PID map if needed
-    if (pid > mm->max_pid) {
-        int new_max_pid = pid + 1000;
-        int* new_pid_map = realloc(mm->pid_to_id_map, sizeof(int) * (new_max_pid + 1));
-        if (!new_pid_map) {
-            if (DEBUG) {
-                printf(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to reallocate PID to ID map\n" ANSI_COLOR_RESET);
-            }
-            return false;
-        }
-        for (int i = mm->max_pid + 1; i <= new_max_pid; i++) {
-            new_pid_map[i] = -1;
+    if (!proc_map_bind_pid(mm->procs, process_id, pid)) {
+        if (DEBUG) {
+            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to map process ID %d to PID %d\n" ANSI_COLOR_RESET,
+                process_id, pid);
         }
-        mm->pid_to_id_map = new_pid_map;
-        mm->max_pid = new_max_pid;
-    }
-    
-    // Clear any existing mapping for this PID
-    if (mm->pid_to_id_map[pid] != -1) {
-        mm->id_to_pid_map[mm->pid_to_id_map[pid]] = -1;
+        return false;
     }
     
-    // Update bidirectional mappings
-    mm->pid_to_id_map[pid] = process_id;
-    mm->id_to_pid_map[process_id] = pid;
-    
     if (DEBUG) {
         printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Mapped process ID %d to PID %d\n" 
             ANSI_COLOR_RESET, process_id, pid);
@@ -408,10 +476,11 @@ bool mm_map_id_to_pid(int process_id, int pid) {
 
 // Implementation for mm_get_pid_by_id
 int mm_get_pid_by_id(int process_id) {
-    if (mm == NULL || process_id < 0 || process_id > mm->max_id) {
+    if (mm == NULL || process_id < 0) {
         return -1;
     }
-    return mm->id_to_pid_map[process_id];
+    proc_record_t* record = proc_map_get(mm->procs, process_id);
+    return record ? record->pid : -1;
 }
 
 // Modified version of mm_free to work with PIDs by first converting to process IDs
@@ -423,15 +492,6 @@ void mm_free(int pid) {
         return;
     }
     
-    // First check if pid is within bounds
-    if (pid > mm->max_pid) {
-        if (DEBUG) {
-            printf(ANSI_COLOR_YELLOW "[MEMORY MANAGER] PID %d exceeds max PID range, assuming no allocation\n" 
-                ANSI_COLOR_RESET, pid);
-        }
-        return;
-    }
-    
     int process_id = mm_get_id_by_pid(pid);
     if (process_id == -1) {
         if (DEBUG) {
@@ -445,8 +505,7 @@ void mm_free(int pid) {
     mm_free_by_id(process_id);
     
     // Clear the bidirectional mapping
-    mm->pid_to_id_map[pid] = -1;
-    mm->id_to_pid_map[process_id] = -1;
+    proc_map_unbind_pid(mm->procs, pid);
     
     if (DEBUG) {
         printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Cleared mapping between PID %d and process ID %d\n" 
@@ -455,7 +514,7 @@ void mm_free(int pid) {
 }
 
 // Implementation for mm_check_pid_allocation - properly handles PIDs
-bool mm_check_pid_allocation(int pid, int* offset, size_t* size) {
+bool mm_check_pid_allocation(int pid, long* offset, size_t* size) {
     if (mm == NULL || pid < 0) {
         if (DEBUG) {
             printf(ANSI_COLOR_RED "[MEMORY MANAGER] Invalid PID %d\n" ANSI_COLOR_RESET, pid);
@@ -463,14 +522,6 @@ bool mm_check_pid_allocation(int pid, int* offset, size_t* size) {
         return false;
     }
     
-    // Check if PID is within bounds
-    if (pid > mm->max_pid) {
-        if (DEBUG) {
-            printf(ANSI_COLOR_YELLOW "[MEMORY MANAGER] PID %d exceeds max PID range\n" ANSI_COLOR_RESET, pid);
-        }
-        return false;
-    }
-
     int process_id = mm_get_id_by_pid(pid);
     if (process_id == -1) {
         if (DEBUG) {
@@ -480,9 +531,7 @@ bool mm_check_pid_allocation(int pid, int* offset, size_t* size) {
     }
     
     // Check if the process ID has memory allocated
-    if (process_id <= mm->max_id && mm->id_to_offset_map[process_id] != -1) {
-        if (offset) *offset = mm->id_to_offset_map[process_id];
-        if (size) *size = mm->id_to_size_map[process_id];
+    if (mm_check_id_allocation(process_id, offset, size)) {
         return true;
     }
     
@@ -500,37 +549,34 @@ void mm_free_by_id(int process_id) {
         return;
     }
     
-    // Check if process_id is within bounds
-    if (process_id > mm->max_id) {
+    proc_record_t* record = proc_map_get(mm->procs, process_id);
+    if (record == NULL || record->offset == -1) {
         if (DEBUG) {
-            printf(ANSI_COLOR_YELLOW "[MEMORY MANAGER] Process ID %d exceeds max ID range, assuming no allocation\n" 
-                ANSI_COLOR_RESET, process_id);
+            printf(ANSI_COLOR_YELLOW "[MEMORY MANAGER] Process ID %d does not have memory allocated\n" ANSI_COLOR_RESET, process_id);
         }
         return;
     }
     
-    // Process IDs may be different from PIDs, but in this implementation
-    // we use them interchangeably with the ID as the array index
-    int offset = mm->id_to_offset_map[process_id];
-    if (offset == -1) {
+    long offset = record->offset;
+    size_t size = record->size;
+    clear_allocation(record);
+    if (allocator_free(mm->memory, offset) == -1) {
         if (DEBUG) {
-            printf(ANSI_COLOR_YELLOW "[MEMORY MANAGER] Process ID %d does not have memory allocated\n" ANSI_COLOR_RESET, process_id);
+            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Allocator rejected free of offset %ld for process ID %d\n"
+                ANSI_COLOR_RESET, offset, process_id);
         }
-        return;
     }
-    
-    size_t size = mm->id_to_size_map[process_id];
-    buddy_free(mm->memory, offset);
     mm_log_memory_deallocation(get_clk(), process_id, size, offset, offset + size - 1);
-    mm->id_to_offset_map[process_id] = -1;
-    mm->id_to_size_map[process_id] = 0;
+    mm->requested_bytes -= size;
+    mm->allocations--;
+    publish_stats();
     
     if (DEBUG) {
-        printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Freed memory at offset %d for process ID %d\n" ANSI_COLOR_RESET, offset, process_id);
+        printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Freed memory at offset %ld for process ID %d\n" ANSI_COLOR_RESET, offset, process_id);
     }
 }
 
-int mm_allocate(int process_id, size_t size) {
+long mm_allocate(int process_id, size_t size) {
     if (mm == NULL) {
         if (DEBUG) {
             printf(ANSI_COLOR_RED "[MEMORY MANAGER] Invalid allocation request: mm is NULL\n" ANSI_COLOR_RESET);
@@ -544,42 +590,27 @@ int mm_allocate(int process_id, size_t size) {
         return -1;
     }
     
-    // Expand ID map if needed
-    if (process_id > mm->max_id) {
-        int new_max_id = process_id + 100;
-        int* new_offset_map = realloc(mm->id_to_offset_map, sizeof(int) * (new_max_id + 1));
-        if (!new_offset_map) return -1;
-        for (int i = mm->max_id + 1; i <= new_max_id; i++) new_offset_map[i] = -1;
-        mm->id_to_offset_map = new_offset_map;
-        
-        size_t* new_size_map = realloc(mm->id_to_size_map, sizeof(size_t) * (new_max_id + 1));
-        if (!new_size_map) return -1;
-        for (int i = mm->max_id + 1; i <= new_max_id; i++) new_size_map[i] = 0;
-        mm->id_to_size_map = new_size_map;
-        
-        int* new_id_to_pid_map = realloc(mm->id_to_pid_map, sizeof(int) * (new_max_id + 1));
-        if (!new_id_to_pid_map) return -1;
-        for (int i = mm->max_id + 1; i <= new_max_id; i++) new_id_to_pid_map[i] = -1;
-        mm->id_to_pid_map = new_id_to_pid_map;
-        
-        mm->max_id = new_max_id;
-    }
-    
     // Check for double allocation
-    if (mm->id_to_offset_map[process_id] != -1) {
+    long previous;
+    if (mm_check_id_allocation(process_id, &previous, NULL)) {
         if (DEBUG) {
-            printf(ANSI_COLOR_YELLOW "[MEMORY MANAGER] Process ID %d already has memory allocated at offset %d, freeing it first\n" 
-                ANSI_COLOR_RESET, process_id, mm->id_to_offset_map[process_id]);
+            printf(ANSI_COLOR_YELLOW "[MEMORY MANAGER] Process ID %d already has memory allocated at offset %ld, freeing it first\n" 
+                ANSI_COLOR_RESET, process_id, previous);
         }
         mm_free_by_id(process_id); // Free previous allocation before re-allocating
     }
     
-    int offset = buddy_alloc(mm->memory, size);
+    long offset = allocator_alloc(mm->memory, size, mm->alloc_flags);
+    if (offset != -1 && !record_allocation(process_id, offset, size)) {
+        return -1;
+    }
     if (offset != -1) {
-        mm->id_to_offset_map[process_id] = offset;
-        mm->id_to_size_map[process_id] = size;
-        mm_log_memory_allocation(get_clk(), process_id, size, offset, offset + size - 1);
-        if (DEBUG) printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Allocated %zu units for process ID %d at offset %d\n" ANSI_COLOR_RESET, size, process_id, offset);
+        mm->requested_bytes += size;
+        mm->allocations++;
+        publish_stats();
+        mm_log_memory_allocation(get_clk(), process_id, size, offset, offset + size - 1,
+                                 allocator_alloc_size(mm->memory, offset));
+        if (DEBUG) printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Allocated %zu units for process ID %d at offset %ld\n" ANSI_COLOR_RESET, size, process_id, offset);
     } else {
         if (DEBUG) {
             printf(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to allocate %zu units for process ID %d (no suitable block found)\n" ANSI_COLOR_RESET, size, process_id);
@@ -589,6 +620,297 @@ int mm_allocate(int process_id, size_t size) {
     return offset;
 }
 
+int mm_allocate_batch(const mm_request_t reqs[], int n, long results[]) {
+    if (mm == NULL || n <= 0) {
+        return 0;
+    }
+
+    int* slots = malloc(sizeof(int) * n);
+    size_t* sizes = malloc(sizeof(size_t) * n);
+    long* offsets = malloc(sizeof(long) * n);
+    if (!slots || !sizes || !offsets) {
+        if (DEBUG) {
+            perror(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to allocate batch buffers" ANSI_COLOR_RESET);
+        }
+        free(slots);
+        free(sizes);
+        free(offsets);
+        return 0;
+    }
+
+    // Drop invalid requests and release any allocation a process ID still holds
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        results[i] = -1;
+        int process_id = reqs[i].process_id;
+        if (process_id < 0) {
+            if (DEBUG) {
+                printf(ANSI_COLOR_RED "[MEMORY MANAGER] Invalid batch request for process ID %d\n" ANSI_COLOR_RESET, process_id);
+            }
+            continue;
+        }
+        if (mm_check_id_allocation(process_id, NULL, NULL)) {
+            mm_free_by_id(process_id);
+        }
+        slots[count] = i;
+        sizes[count] = reqs[i].size;
+        count++;
+    }
+
+    int allocated = allocator_alloc_batch(mm->memory, sizes, count, offsets, mm->alloc_flags);
+
+    int time = get_clk();
+    for (int k = 0; k < count; k++) {
+        const mm_request_t* req = &reqs[slots[k]];
+        if (offsets[k] == -1) {
+            continue;
+        }
+        if (!record_allocation(req->process_id, offsets[k], req->size)) {
+            allocated--;
+            continue;
+        }
+        results[slots[k]] = offsets[k];
+        mm->requested_bytes += req->size;
+        mm->allocations++;
+        mm_log_memory_allocation(time, req->process_id, req->size, offsets[k], offsets[k] + req->size - 1,
+                                 allocator_alloc_size(mm->memory, offsets[k]));
+    }
+
+    publish_stats();
+
+    if (DEBUG) {
+        printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Batch allocated %d of %d request(s)\n" ANSI_COLOR_RESET, allocated, n);
+    }
+
+    free(slots);
+    free(sizes);
+    free(offsets);
+    return allocated;
+}
+
+int mm_free_batch(const int ids[], int n) {
+    if (mm == NULL || n <= 0) {
+        return 0;
+    }
+
+    long* offsets = malloc(sizeof(long) * n);
+    size_t* sizes = malloc(sizeof(size_t) * n);
+    int* freed_ids = malloc(sizeof(int) * n);
+    if (!offsets || !sizes || !freed_ids) {
+        if (DEBUG) {
+            perror(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to allocate batch buffers" ANSI_COLOR_RESET);
+        }
+        free(offsets);
+        free(sizes);
+        free(freed_ids);
+        return 0;
+    }
+
+    // Detach each allocation from its ID first, so a repeated ID is only freed once
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        int process_id = ids[i];
+        proc_record_t* record = proc_map_get(mm->procs, process_id);
+        if (record == NULL || record->offset == -1) {
+            if (DEBUG) {
+                printf(ANSI_COLOR_YELLOW "[MEMORY MANAGER] Process ID %d does not have memory allocated\n" ANSI_COLOR_RESET, process_id);
+            }
+            continue;
+        }
+        offsets[count] = record->offset;
+        sizes[count] = record->size;
+        freed_ids[count] = process_id;
+        record->offset = -1;
+        record->size = 0;
+        mm->requested_bytes -= sizes[count];
+        mm->allocations--;
+        count++;
+    }
+
+    if (allocator_free_batch(mm->memory, offsets, count) == -1) {
+        if (DEBUG) {
+            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Allocator rejected part of a batch of %d frees\n" ANSI_COLOR_RESET, count);
+        }
+    }
+    publish_stats();
+
+    int time = get_clk();
+    for (int k = 0; k < count; k++) {
+        int process_id = freed_ids[k];
+        mm_log_memory_deallocation(time, process_id, sizes[k], offsets[k], offsets[k] + sizes[k] - 1);
+
+        // Finished processes give up their PID mapping too, as with mm_free
+        proc_map_remove(mm->procs, process_id);
+    }
+
+    if (DEBUG) {
+        printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Batch freed %d of %d process ID(s)\n" ANSI_COLOR_RESET, count, n);
+    }
+
+    free(offsets);
+    free(sizes);
+    free(freed_ids);
+    return count;
+}
+
+// Add unused reservation slots, doubling the table
+static bool grow_reservations() {
+    int capacity = mm->reservation_capacity ? mm->reservation_capacity * 2 : 16;
+    reservation_t* grown = realloc(mm->reservations, sizeof(reservation_t) * capacity);
+    if (!grown) {
+        if (DEBUG) {
+            perror(ANSI_COLOR_RED "[MEMORY MANAGER] Failed to grow reservation table" ANSI_COLOR_RESET);
+        }
+        return false;
+    }
+    for (int i = capacity - 1; i >= mm->reservation_capacity; i--) {
+        grown[i].offset = -1;
+        grown[i].next_free = mm->free_reservation;
+        mm->free_reservation = i;
+    }
+    mm->reservations = grown;
+    mm->reservation_capacity = capacity;
+    return true;
+}
+
+static reservation_t* lookup_reservation(mm_token_t token) {
+    if (mm == NULL || token < 0 || token >= mm->reservation_capacity || mm->reservations[token].offset == -1) {
+        if (DEBUG) {
+            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Invalid reservation token %d\n" ANSI_COLOR_RESET, token);
+        }
+        return NULL;
+    }
+    return &mm->reservations[token];
+}
+
+static void release_reservation(mm_token_t token) {
+    mm->reservations[token].offset = -1;
+    mm->reservations[token].next_free = mm->free_reservation;
+    mm->free_reservation = token;
+}
+
+mm_token_t mm_reserve(size_t size) {
+    if (mm == NULL || (mm->free_reservation == -1 && !grow_reservations())) {
+        return MM_NO_TOKEN;
+    }
+
+    long offset = allocator_alloc(mm->memory, size, mm->alloc_flags);
+    if (offset == -1) {
+        return MM_NO_TOKEN;
+    }
+
+    mm_token_t token = mm->free_reservation;
+    reservation_t* reservation = &mm->reservations[token];
+    mm->free_reservation = reservation->next_free;
+    reservation->offset = offset;
+    reservation->size = size;
+    mm->requested_bytes += size;
+    mm->allocations++;
+    publish_stats();
+
+    if (DEBUG) {
+        printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Reserved %zu bytes at offset %ld (token %d)\n"
+            ANSI_COLOR_RESET, size, offset, token);
+    }
+    return token;
+}
+
+bool mm_commit(mm_token_t token, int process_id, int pid) {
+    reservation_t* reservation = lookup_reservation(token);
+    if (reservation == NULL) {
+        return false;
+    }
+    if (mm_check_id_allocation(process_id, NULL, NULL)) {
+        mm_free_by_id(process_id);
+    }
+    proc_record_t* record = proc_map_put(mm->procs, process_id);
+    if (record == NULL) {
+        if (DEBUG) {
+            printf(ANSI_COLOR_RED "[MEMORY MANAGER] Cannot commit token %d to process ID %d\n"
+                ANSI_COLOR_RESET, token, process_id);
+        }
+        // Nothing would ever free memory no process ID owns
+        mm_cancel(token);
+        return false;
+    }
+
+    long offset = reservation->offset;
+    size_t size = reservation->size;
+    release_reservation(token);
+    record->offset = offset;
+    record->size = size;
+    mm_log_memory_allocation(get_clk(), process_id, size, offset, offset + size - 1,
+                             allocator_alloc_size(mm->memory, offset));
+    if (pid >= 0) {
+        mm_map_pid_to_id(pid, process_id);
+    }
+
+    if (DEBUG) {
+        printf(ANSI_COLOR_GREEN "[MEMORY MANAGER] Committed token %d to process ID %d at offset %ld\n"
+            ANSI_COLOR_RESET, token, process_id, offset);
+    }
+    return true;
+}
+
+void mm_cancel(mm_token_t token) {
+    reservation_t* reservation = lookup_reservation(token);
+    if (reservation == NULL) {
+        return;
+    }
+    if (allocator_free(mm->memory, reservation->offset) == -1 && DEBUG) {
+        printf(ANSI_COLOR_RED "[MEMORY MANAGER] Allocator rejected cancelled reservation at offset %ld\n"
+            ANSI_COLOR_RESET, reservation->offset);
+    }
+    mm->requested_bytes -= reservation->size;
+    mm->allocations--;
+    release_reservation(token);
+    publish_stats();
+
+    if (DEBUG) {
+        printf(ANSI_COLOR_YELLOW "[MEMORY MANAGER] Cancelled reservation token %d\n" ANSI_COLOR_RESET, token);
+    }
+}
+
+bool mm_can_fit(size_t size) {
+    return mm != NULL && allocator_can_fit(mm->memory, size, mm->alloc_flags);
+}
+
+// Release a process's memory to the swap device; its PID mapping stays
+bool mm_swap_out(int process_id) {
+    proc_record_t* record = mm == NULL ? NULL : proc_map_get(mm->procs, process_id);
+    if (record == NULL || record->offset == -1) {
+        return false;
+    }
+    long offset = record->offset;
+    size_t size = record->size;
+    clear_allocation(record);
+    if (allocator_free(mm->memory, offset) == -1 && DEBUG) {
+        printf(ANSI_COLOR_RED "[MEMORY MANAGER] Allocator rejected swap-out of offset %ld for process ID %d\n"
+            ANSI_COLOR_RESET, offset, process_id);
+    }
+    mm->requested_bytes -= size;
+    mm->allocations--;
+    publish_stats();
+    mm_log_memory_swap(get_clk(), process_id, size, offset, offset + size - 1, false);
+    return true;
+}
+
+// Give a swapped-out process memory again, wherever it fits now
+long mm_swap_in(int process_id, size_t size) {
+    if (mm == NULL || process_id < 0 || mm_check_id_allocation(process_id, NULL, NULL)) {
+        return -1;
+    }
+    long offset = allocator_alloc(mm->memory, size, mm->alloc_flags);
+    if (offset == -1 || !record_allocation(process_id, offset, size)) {
+        return -1;
+    }
+    mm->requested_bytes += size;
+    mm->allocations++;
+    publish_stats();
+    mm_log_memory_swap(get_clk(), process_id, size, offset, offset + size - 1, true);
+    return offset;
+}
+
 int mm_add_to_waiting_list(processParameters* process_params) {
     if (mm == NULL || process_params == NULL) {
         return -1;
@@ -604,60 +926,311 @@ int mm_add_to_waiting_list(processParameters* process_params) {
     memcpy(&waiting_process->params, process_params, sizeof(processParameters));
     waiting_process->params.pid = 0; // PID not known until fork
     waiting_process->size = process_params->memsize;
-    min_heap_insert(mm->waiting_list, waiting_process);
+    waiting_process->seq = mm->waiting_seq++;
+    waiting_process->next = NULL;
+
+    int k = size_class(waiting_process->size);
+    if (mm->waiting_tail[k] != NULL) {
+        mm->waiting_tail[k]->next = waiting_process;
+    } else {
+        mm->waiting_head[k] = waiting_process;
+    }
+    mm->waiting_tail[k] = waiting_process;
+    mm->waiting_classes |= 1ull << k;
+    mm->waiting_count++;
+    publish_stats();
     if (DEBUG) {
-        printf(ANSI_COLOR_CYAN "[MEMORY MANAGER] Added process ID %d to waiting list (size: %zu, position: %d)\n"
-            ANSI_COLOR_RESET, process_params->id, waiting_process->size, mm->waiting_list->size);
+        printf(ANSI_COLOR_CYAN "[MEMORY MANAGER] Added process ID %d to waiting list (size: %zu, order %d, %d waiting)\n"
+            ANSI_COLOR_RESET, process_params->id, waiting_process->size, k, mm->waiting_count);
+    }
+    return mm->waiting_count;
+}
+
+static const char* admission_names[ADMIT_COUNT] = {
+    [ADMIT_SMALLEST_FIRST] = "smallest",
+    [ADMIT_FIFO] = "fifo",
+    [ADMIT_BACKFILL] = "backfill",
+};
+
+const char* admission_policy_name(admission_policy_t policy) {
+    if (policy < 0 || policy >= ADMIT_COUNT) {
+        return "unknown";
+    }
+    return admission_names[policy];
+}
+
+int parse_admission_policy(const char* name) {
+    for (int policy = 0; policy < ADMIT_COUNT; policy++) {
+        if (strcmp(name, admission_names[policy]) == 0) {
+            return policy;
+        }
+    }
+    return -1;
+}
+
+void mm_set_admission(admission_policy_t policy) {
+    if (mm != NULL) {
+        mm->admission = policy;
+    }
+}
+
+// Admitted work is projected to run back to back on the one CPU: a process that needs
+// runtime ticks finishes that long after everything admitted before it
+static int projected_finish(int runtime, int now) {
+    return (mm->release_horizon > now ? mm->release_horizon : now) + runtime;
+}
+
+void mm_project_release(int process_id, int runtime) {
+    if (mm == NULL) {
+        return;
+    }
+    proc_record_t* record = proc_map_get(mm->procs, process_id);
+    if (record != NULL) {
+        record->release_at = projected_finish(runtime, get_clk());
+        mm->release_horizon = record->release_at;
+    }
+}
+
+// Take a waiting process off bucket k (prev is the one before it, NULL for the head)
+static void unlink_waiting(int k, waiting_process_t* prev, waiting_process_t* process) {
+    if (prev != NULL) {
+        prev->next = process->next;
+    } else {
+        mm->waiting_head[k] = process->next;
+    }
+    if (mm->waiting_tail[k] == process) {
+        mm->waiting_tail[k] = prev;
+    }
+    if (mm->waiting_head[k] == NULL) {
+        mm->waiting_classes &= ~(1ull << k);
+    }
+    mm->waiting_count--;
+}
+
+// Admit a waiting process that fits: reserve its memory under *token and take it off the list
+static processParameters* admit_waiting(int k, waiting_process_t* prev, waiting_process_t* process,
+                                        mm_token_t* token) {
+    processParameters* result = malloc(sizeof(processParameters));
+    if (!result) {
+        return NULL;
+    }
+    *token = mm_reserve(process->size);
+    if (*token == MM_NO_TOKEN) {
+        free(result);
+        return NULL;
+    }
+    memcpy(result, &process->params, sizeof(processParameters));
+    unlink_waiting(k, prev, process);
+    free(process);
+    publish_stats();
+    return result;
+}
+
+// Buckets are FIFO, so the oldest waiting process heads one of them
+static waiting_process_t* oldest_waiting(int* bucket) {
+    waiting_process_t* oldest = NULL;
+    for (uint64_t classes = mm->waiting_classes; classes; classes &= classes - 1) {
+        int k = __builtin_ctzll(classes);
+        if (oldest == NULL || mm->waiting_head[k]->seq < oldest->seq) {
+            oldest = mm->waiting_head[k];
+            *bucket = k;
+        }
+    }
+    return oldest;
+}
+
+// Whether every request in a bucket takes the same block: the buddy rounds each one up
+// to its bucket's power of 2 unless it trims the tail
+static bool rounds_to_bucket() {
+    return mm->memory->policy == ALLOC_POLICY_BUDDY && !(mm->alloc_flags & ALLOC_TRIM);
+}
+
+// Bytes the allocator will set aside for a request of size
+static size_t projected_size(size_t size) {
+    return allocator_reserved_size(mm->memory, size, mm->alloc_flags);
+}
+
+// Oldest process in the lowest bucket that fits now (*prev is the one before it), or NULL.
+// Fitting is monotone in size and every request in a higher bucket is larger than any in
+// the lowest one, so if none of these fits nothing else can
+static waiting_process_t* smallest_fitting(int* bucket, waiting_process_t** prev) {
+    int k = __builtin_ctzll(mm->waiting_classes);
+    *bucket = k;
+    *prev = NULL;
+    for (waiting_process_t* process = mm->waiting_head[k]; process != NULL; *prev = process, process = process->next) {
+        if (allocator_can_fit(mm->memory, process->size, mm->alloc_flags)) {
+            return process;
+        }
+        if (rounds_to_bucket()) {
+            return NULL;    // The rest of the bucket needs the same block
+        }
+    }
+    return NULL;
+}
+
+static int compare_releases(const void* a, const void* b) {
+    return ((const projected_release_t*)a)->tick - ((const projected_release_t*)b)->tick;
+}
+
+typedef struct {
+    int now;
+    int count;
+} release_walk_t;
+
+// Append the projected release of a record that holds memory to mm->releases
+static void collect_release(proc_record_t* record, void* arg) {
+    release_walk_t* walk = arg;
+    if (record->offset == -1) {
+        return;
+    }
+    projected_release_t* release = &mm->releases[walk->count++];
+    release->tick = record->release_at == -1 ? INT_MAX
+        : record->release_at > walk->now ? record->release_at : walk->now + 1;
+    release->bytes = allocator_alloc_size(mm->memory, record->offset);
+}
+
+/*
+ * EASY reservation for a process that does not fit: walk the live allocations in
+ * order of projected release, adding up their bytes, until enough are free. That
+ * tick is the reservation; *extra is the bytes still spare at it, which later
+ * processes may hold past it without delaying the reserved one. Allocations whose
+ * release is overdue are taken to end next tick. Returns INT_MAX if the releases never
+ * free enough, as then nothing can delay it.
+ *
+ * Contiguity is not projected, as that would mean replaying the frees in the allocator.
+ * If the bytes are already free but too fragmented for the process, the reservation is
+ * put at the next release, on the assumption that it merges enough free space: this is
+ * a heuristic. If it proves wrong the process still does not fit at that tick, and the
+ * next call projects a new reservation from there, so it is only ever postponed one
+ * release at a time; meanwhile backfilling is held to what that first release allows.
+ */
+static int reservation_time(size_t size, int now, size_t* extra) {
+    *extra = 0;
+    if (mm->release_capacity < mm->procs->record_count) {
+        int capacity = mm->release_capacity ? mm->release_capacity : 16;
+        while (capacity < mm->procs->record_count) {
+            capacity *= 2;
+        }
+        projected_release_t* grown = realloc(mm->releases, sizeof(projected_release_t) * capacity);
+        if (!grown) {
+            return now;
+        }
+        mm->releases = grown;
+        mm->release_capacity = capacity;
+    }
+    projected_release_t* releases = mm->releases;
+    release_walk_t walk = { .now = now, .count = 0 };
+    proc_map_foreach(mm->procs, collect_release, &walk);
+    int count = walk.count;
+    qsort(releases, count, sizeof(projected_release_t), compare_releases);
+
+    allocator_stats_t alloc_stats;
+    allocator_stats(mm->memory, &alloc_stats);
+    size_t available = alloc_stats.free_bytes;
+    size_t needed = projected_size(size);
+    int shadow = now;
+    int i = 0;
+    // Enough bytes but fragmented: assume the next release lets it fit (see above)
+    if (available >= needed && count > 0) {
+        available += releases[0].bytes;
+        shadow = releases[0].tick;
+        i = 1;
     }
-    return mm->waiting_list->size;
+    for (; i < count && available < needed; i++) {
+        available += releases[i].bytes;
+        shadow = releases[i].tick;
+    }
+    if (available < needed || shadow == INT_MAX) {
+        return INT_MAX;
+    }
+    *extra = available - needed;
+    return shadow;
 }
 
-processParameters* mm_get_next_allocatable_process() {
-    if (mm == NULL || min_heap_is_empty(mm->waiting_list)) {
+// The process that fits leaves with its memory reserved under *token. Policies:
+// smallest: smaller requests go first, as they are the most likely to fit: the oldest
+//   process in the lowest bucket that fits now.
+// fifo: the oldest process only, so none is overtaken.
+// backfill: the oldest process if it fits; otherwise it gets a reservation, and a later
+//   one may go first if it fits now and either is projected to finish by the
+//   reservation or fits in the memory spare at it. If no reservation can be projected,
+//   nothing overtakes the oldest, as with fifo.
+processParameters* mm_get_next_allocatable_process(mm_token_t* token) {
+    *token = MM_NO_TOKEN;
+    if (mm == NULL || mm->waiting_classes == 0) {
         return NULL;
     }
-    int waiting_count = mm->waiting_list->size;
-    waiting_process_t** waiting_copy = malloc(waiting_count * sizeof(waiting_process_t*));
-    if (!waiting_copy) return NULL;
-    for (int i = 0; i < waiting_count; i++) waiting_copy[i] = min_heap_extract_min(mm->waiting_list);
-    processParameters* result = NULL;
-    int allocated_index = -1;
-    for (int i = 0; i < waiting_count; i++) {
-        if (waiting_copy[i]) {
-            // Try to allocate memory (simulate, since PID not known yet)
-            int offset = buddy_alloc(mm->memory, waiting_copy[i]->size);
-            if (offset != -1) {
-                // Do NOT record allocation yet, just return the process parameters
-                result = malloc(sizeof(processParameters));
-                if (!result) {
-                    buddy_free(mm->memory, offset);
-                    continue;
+    if (mm->admission == ADMIT_SMALLEST_FIRST) {
+        int k;
+        waiting_process_t* prev;
+        waiting_process_t* process = smallest_fitting(&k, &prev);
+        if (process == NULL) {
+            return NULL;
+        }
+        return admit_waiting(k, prev, process, token);
+    }
+
+    int oldest_bucket = 0;
+    waiting_process_t* oldest = oldest_waiting(&oldest_bucket);
+    if (allocator_can_fit(mm->memory, oldest->size, mm->alloc_flags)) {
+        return admit_waiting(oldest_bucket, NULL, oldest, token);
+    }
+    if (mm->admission == ADMIT_FIFO) {
+        return NULL;
+    }
+
+    int now = get_clk();
+    size_t extra;
+    int shadow = reservation_time(oldest->size, now, &extra);
+    for (uint64_t classes = mm->waiting_classes; classes; classes &= classes - 1) {
+        int k = __builtin_ctzll(classes);
+        waiting_process_t* prev = NULL;
+        for (waiting_process_t* process = mm->waiting_head[k]; process != NULL; prev = process, process = process->next) {
+            if (process == oldest || !allocator_can_fit(mm->memory, process->size, mm->alloc_flags)) {
+                continue;
+            }
+            // Without a reservation (INT_MAX) no finish is early enough, and nothing is spare
+            bool done_by_shadow = shadow != INT_MAX && projected_finish(process->params.runtime, now) <= shadow;
+            if (done_by_shadow || projected_size(process->size) <= extra) {
+                if (DEBUG) {
+                    printf(ANSI_COLOR_CYAN "[MEMORY MANAGER] Backfilling process ID %d ahead of process ID %d "
+                        "(reserved for time %d)\n" ANSI_COLOR_RESET, process->params.id, oldest->params.id, shadow);
                 }
-                memcpy(result, &waiting_copy[i]->params, sizeof(processParameters));
-                // Free buddy block, will be re-allocated after fork with real PID
-                buddy_free(mm->memory, offset);
-                allocated_index = i;
-                break;
+                return admit_waiting(k, prev, process, token);
             }
         }
     }
-    for (int i = 0; i < waiting_count; i++) {
-        if (i != allocated_index && waiting_copy[i]) min_heap_insert(mm->waiting_list, waiting_copy[i]);
-        else if (i == allocated_index) free(waiting_copy[i]);
+    return NULL;
+}
+
+size_t mm_get_next_waiting_size() {
+    if (mm == NULL || mm->waiting_classes == 0) {
+        return 0;
+    }
+    if (mm->admission != ADMIT_SMALLEST_FIRST) {
+        int k;
+        return oldest_waiting(&k)->size;
     }
-    free(waiting_copy);
-    return result;
+    // The smallest request is the one that needs the least room made for it
+    size_t smallest = SIZE_MAX;
+    for (waiting_process_t* process = mm->waiting_head[__builtin_ctzll(mm->waiting_classes)]; process != NULL;
+         process = process->next) {
+        if (process->size < smallest) {
+            smallest = process->size;
+        }
+    }
+    return smallest;
 }
 
 bool mm_has_waiting_processes() {
-    return mm != NULL && !min_heap_is_empty(mm->waiting_list);
+    return mm != NULL && mm->waiting_count > 0;
 }
 
 int mm_get_waiting_count() {
-    if (mm == NULL || mm->waiting_list == NULL) {
+    if (mm == NULL) {
         return 0;
     }
-    return mm->waiting_list->size;
+    return mm->waiting_count;
 }
 
 void mm_dump_memory() {
@@ -667,19 +1240,21 @@ void mm_dump_memory() {
     }
     
     printf(ANSI_COLOR_CYAN "[MEMORY MANAGER] Waiting list (%d processes):\n" ANSI_COLOR_RESET,
-        mm->waiting_list->size);
+        mm->waiting_count);
     
     // Show waiting processes if any
-    if (!min_heap_is_empty(mm->waiting_list)) {
-        waiting_process_t* top = min_heap_get_min(mm->waiting_list);
+    if (mm->waiting_classes != 0) {
+        waiting_process_t* top = mm->waiting_head[__builtin_ctzll(mm->waiting_classes)];
         printf(ANSI_COLOR_CYAN "[MEMORY MANAGER] First waiting process: ID %d, size %zu\n" ANSI_COLOR_RESET,
             top->params.id, top->size);
     }
     
     // Report total memory stats
-    size_t total_memory = 0;
-    mm_get_stats(&total_memory, NULL, NULL);
-    printf(ANSI_COLOR_CYAN "[MEMORY MANAGER] Total memory: %zu units\n" ANSI_COLOR_RESET, total_memory);
+    size_t total_memory = 0, free_memory = 0, largest_block = 0;
+    mm_get_stats(&total_memory, &free_memory, &largest_block);
+    printf(ANSI_COLOR_CYAN "[MEMORY MANAGER] Total memory: %zu units, %zu free, largest free block %zu, "
+        "%zu lost to internal fragmentation\n" ANSI_COLOR_RESET,
+        total_memory, free_memory, largest_block, mm_get_internal_fragmentation());
 }
 
 void mm_get_stats(size_t* total_memory, size_t* free_memory, size_t* largest_block) {
@@ -689,20 +1264,25 @@ void mm_get_stats(size_t* total_memory, size_t* free_memory, size_t* largest_blo
         if (largest_block) *largest_block = 0;
         return;
     }
-    
-    // For now, we'll just set the values we know
-    if (total_memory) {
-        *total_memory = buddy_get_size(mm->memory);
+
+    allocator_stats_t alloc_stats;
+    allocator_stats(mm->memory, &alloc_stats);
+    if (total_memory) *total_memory = alloc_stats.total_bytes;
+    if (free_memory) *free_memory = alloc_stats.free_bytes;
+    if (largest_block) *largest_block = alloc_stats.largest_free;
+}
+
+size_t mm_get_internal_fragmentation() {
+    if (mm == NULL) {
+        return 0;
     }
-    
-    // Note: Getting free memory and largest block would require
-    // additional functionality in the buddy system that we don't have yet
-    if (free_memory) *free_memory = 0;  // Placeholder
-    if (largest_block) *largest_block = 0;  // Placeholder
+    allocator_stats_t alloc_stats;
+    allocator_stats(mm->memory, &alloc_stats);
+    return alloc_stats.total_bytes - alloc_stats.free_bytes - mm->requested_bytes;
 }
 
 // Implementation for mm_allocate_by_id
-int mm_allocate_by_id(int process_id, size_t size) {
+long mm_allocate_by_id(int process_id, size_t size) {
     if (mm == NULL) {
         if (DEBUG) {
             printf(ANSI_COLOR_RED "[MEMORY MANAGER] Invalid allocation request: mm is NULL\n" ANSI_COLOR_RESET);
@@ -716,12 +1296,11 @@ int mm_allocate_by_id(int process_id, size_t size) {
 
 
 // Implementation for mm_check_id_allocation
-bool mm_check_id_allocation(int process_id, int* offset, size_t* size) {
-    if (mm == NULL || process_id < 0 || process_id > mm->max_id) return false;
-    if (mm->id_to_offset_map[process_id] != -1) {
-        if (offset) *offset = mm->id_to_offset_map[process_id];
-        if (size) *size = mm->id_to_size_map[process_id];
-        return true;
-    }
-    return false;
+bool mm_check_id_allocation(int process_id, long* offset, size_t* size) {
+    if (mm == NULL) return false;
+    proc_record_t* record = proc_map_get(mm->procs, process_id);
+    if (record == NULL || record->offset == -1) return false;
+    if (offset) *offset = record->offset;
+    if (size) *size = record->size;
+    return true;
 }
@@ -2,39 +2,81 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include "../data_structures/min_heap.h"
-#include "buddy.h"
+#include "allocator.h"
 #include "headers.h"
 #include "clk.h"
 // Memory Manager Structure
-bool mm_init(unsigned int memory_size);
+bool mm_init(size_t memory_size, size_t min_block, alloc_policy_t policy); // Sizes in bytes
+bool mm_init_arenas(const arena_spec_t specs[], int count, size_t min_block, placement_policy_t placement,
+                    bool locked);                   // Arena k follows arena k - 1 in the address space
 void mm_destroy();
+void mm_set_trim(bool enabled);                     // Trimmed allocations keep only the blocks a request needs
+bool mm_grow(size_t new_size, bool independent_roots); // Hot-add memory; existing allocations keep their offsets
 
 // Memory Manager Functions
-int mm_allocate(int pid, size_t size);
-int mm_allocate_by_id(int process_id, size_t size); // New function for allocating by process ID
+long mm_allocate(int pid, size_t size);
+long mm_allocate_by_id(int process_id, size_t size); // New function for allocating by process ID
 void mm_free(int pid);
 void mm_free_by_id(int process_id);                 // New function for freeing by process ID
 
+// Batched allocation and release, for processes that arrive or finish in the same tick
+typedef struct {
+    int process_id;
+    size_t size;
+} mm_request_t;
+int mm_allocate_batch(const mm_request_t reqs[], int n, long results[]); // results[i] is -1 if request i did not fit; returns how many fit
+int mm_free_batch(const int ids[], int n);          // Frees by process ID and drops PID mappings; returns how many were freed
+
+// Reservations: admission takes the memory once, and it is handed to the process after fork
+typedef int mm_token_t;
+#define MM_NO_TOKEN -1
+mm_token_t mm_reserve(size_t size);                 // MM_NO_TOKEN if the size does not fit
+// pid -1 leaves the PID mapping alone; on failure the reservation is cancelled
+bool mm_commit(mm_token_t token, int process_id, int pid);
+void mm_cancel(mm_token_t token);                   // Give reserved memory back unused
+
+// Swapping: memory leaves and returns by process ID; the PID mapping is kept throughout
+bool mm_can_fit(size_t size);                       // Whether an allocation of size would succeed now
+bool mm_swap_out(int process_id);
+long mm_swap_in(int process_id, size_t size);       // New offset, or -1 if it does not fit
+
 // Check if a PID has memory allocated
-bool mm_check_pid_allocation(int pid, int* offset, size_t* size);
-bool mm_check_id_allocation(int process_id, int* offset, size_t* size); // Check allocation by process ID
+bool mm_check_pid_allocation(int pid, long* offset, size_t* size);
+bool mm_check_id_allocation(int process_id, long* offset, size_t* size); // Check allocation by process ID
 
 // Map process ID to PID
+bool mm_map_pid_to_id(int pid, int process_id);     // Create mapping between PID and process ID
 bool mm_map_id_to_pid(int process_id, int pid);     // Create mapping between process ID and PID
 int mm_get_pid_by_id(int process_id);               // Get PID by process ID
+int mm_get_id_by_pid(int pid);                      // Get process ID by PID
 
 // Waiting List Functions
+typedef enum {
+    ADMIT_SMALLEST_FIRST,     // Smallest waiting request that fits
+    ADMIT_FIFO,               // Oldest waiting process only
+    ADMIT_BACKFILL,           // Oldest first; later ones only if they do not delay its reservation (EASY)
+    ADMIT_COUNT
+} admission_policy_t;
+const char* admission_policy_name(admission_policy_t policy);
+int parse_admission_policy(const char* name);
+void mm_set_admission(admission_policy_t policy);
+void mm_project_release(int process_id, int runtime); // Once admitted: when its memory should be freed, for backfilling
 int mm_add_to_waiting_list(processParameters* process_params);
-processParameters* mm_get_next_allocatable_process();
+processParameters* mm_get_next_allocatable_process(mm_token_t* token); // Reserves the returned process's memory
 bool mm_has_waiting_processes();
+size_t mm_get_next_waiting_size();                  // Size the next admission needs (0 if none wait)
 int mm_get_waiting_count();
 
 // Memory logging functions
 void mm_initialize_memory_log();
-void mm_log_memory_allocation(int time, int id, int size, int start_address, int end_address);
-void mm_log_memory_deallocation(int time, int id, int size, int start_address, int end_address);
+void mm_log_memory_allocation(int time, int id, int size, long start_address, long end_address, size_t reserved);
+void mm_log_memory_deallocation(int time, int id, int size, long start_address, long end_address);
+void mm_log_memory_growth(int time, size_t old_size, size_t new_size);
+void mm_log_memory_swap(int time, int id, int size, long start_address, long end_address, bool swap_in);
+void mm_flush_memory_log();                         // Write out buffered events; once per tick
 void mm_close_memory_log();
 
 // Debugging functions
 void mm_dump_memory();
-void mm_get_stats(size_t* total_memory, size_t* free_memory, size_t* largest_block);
\ No newline at end of file
+void mm_get_stats(size_t* total_memory, size_t* free_memory, size_t* largest_block);
+size_t mm_get_internal_fragmentation();             // Bytes reserved beyond what live allocations asked for
\ No newline at end of file
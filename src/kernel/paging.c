@@ -0,0 +1,448 @@
+#include "paging.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "colors.h"
+
+/*
+ * Paging:
+    * 1. Physical memory is split into frames of page_size bytes, shared by every process.
+    *    Each process has a page table mapping its pages to frames, empty at first, so
+    *    every page is loaded on its first reference (demand paging).
+    * 2. A reference first looks up the TLB, a set-associative cache of (process, page)
+    *    -> frame tagged by process ID, so dispatching never flushes it. Misses walk the
+    *    page table and refill the TLB's least recently used way in the set.
+    * 3. A page that is not resident faults. It takes a free frame if there is one, or
+    *    evicts a victim chosen by the replacement policy from all resident pages; an
+    *    evicted dirty page is written back first. Evictions and releases shoot down the
+    *    TLB entry of the page.
+    * 4. References follow a per-process locality model: most fall inside a working set
+    *    of consecutive pages that moves every few ticks, the rest anywhere in the
+    *    process. Its parameters are drawn from a generator seeded with the process ID,
+    *    so a trace replays the same references under every policy.
+*/
+
+typedef struct frame {
+    int owner;                  // Process ID, -1 while free
+    int page;
+    bool referenced;
+    bool dirty;
+    int prev, next;             // FIFO/LRU order of resident frames, oldest first
+} frame_t;
+
+typedef struct tlb_entry {
+    int owner;                  // -1 while invalid
+    int page;
+    int frame;
+    long last_used;
+} tlb_entry_t;
+
+typedef struct page_table {
+    int* frames;                // Frame of each page, -1 if not resident; NULL without a table
+    int pages;
+    uint32_t random;            // Locality model state
+    int ws_base;                // First page of the working set
+    int ws_size;
+    int phase_length;           // References between working set moves
+    int phase_left;
+    float locality;             // Share of references inside the working set
+    float write_ratio;
+    paging_stats_t stats;
+} page_table_t;
+
+static paging_config_t config;
+static frame_t* frames = NULL;
+static int frame_count = 0;
+static int* free_frames = NULL;         // Stack of free frame numbers
+static int free_count = 0;
+static int list_head = -1, list_tail = -1;
+static int hand = 0;                    // Clock hand
+static tlb_entry_t* tlb = NULL;
+static int tlb_sets = 0;
+static long tlb_clock = 0;
+static page_table_t* tables = NULL;     // Indexed by process ID
+static int table_capacity = 0;
+
+static const char* policy_names[PAGE_POLICY_COUNT] = {
+    [PAGE_POLICY_FIFO] = "fifo",
+    [PAGE_POLICY_LRU] = "lru",
+    [PAGE_POLICY_CLOCK] = "clock",
+    [PAGE_POLICY_SECOND_CHANCE] = "second-chance",
+};
+
+const char* page_policy_name(page_policy_t policy) {
+    if (policy < 0 || policy >= PAGE_POLICY_COUNT) {
+        return "unknown";
+    }
+    return policy_names[policy];
+}
+
+int parse_page_policy(const char* name) {
+    for (int policy = 0; policy < PAGE_POLICY_COUNT; policy++) {
+        if (strcmp(name, policy_names[policy]) == 0) {
+            return policy;
+        }
+    }
+    return -1;
+}
+
+bool paging_init(const paging_config_t* settings, int max_process_id) {
+    if (settings->page_size == 0 || settings->memory_size < settings->page_size || settings->tlb_ways < 1
+        || settings->tlb_entries < settings->tlb_ways || settings->tlb_entries % settings->tlb_ways) {
+        return false;
+    }
+    config = *settings;
+    frame_count = config.memory_size / config.page_size;
+    tlb_sets = config.tlb_entries / config.tlb_ways;
+    table_capacity = max_process_id + 1;
+
+    frames = malloc(sizeof(frame_t) * frame_count);
+    free_frames = malloc(sizeof(int) * frame_count);
+    tlb = malloc(sizeof(tlb_entry_t) * config.tlb_entries);
+    tables = calloc(table_capacity, sizeof(page_table_t));
+    if (!frames || !free_frames || !tlb || !tables) {
+        perror("Failed to allocate paging structures");
+        paging_destroy();
+        return false;
+    }
+
+    // Hand out low frames first
+    for (int k = 0; k < frame_count; k++) {
+        frames[k].owner = -1;
+        free_frames[k] = frame_count - 1 - k;
+    }
+    free_count = frame_count;
+    for (int k = 0; k < config.tlb_entries; k++) {
+        tlb[k].owner = -1;
+    }
+
+    if (DEBUG) {
+        printf(ANSI_COLOR_CYAN "[PAGING] %d frames of %zu bytes, %s replacement, %d-entry %d-way TLB\n" ANSI_COLOR_RESET,
+            frame_count, config.page_size, page_policy_name(config.policy), config.tlb_entries, config.tlb_ways);
+    }
+    return true;
+}
+
+bool paging_enabled() {
+    return frames != NULL;
+}
+
+void paging_destroy() {
+    if (tables != NULL) {
+        for (int id = 0; id < table_capacity; id++) {
+            free(tables[id].frames);
+        }
+    }
+    free(frames);
+    free(free_frames);
+    free(tlb);
+    free(tables);
+    frames = NULL;
+    free_frames = NULL;
+    tlb = NULL;
+    tables = NULL;
+}
+
+static page_table_t* table_of(int process_id) {
+    if (tables == NULL || process_id < 0 || process_id >= table_capacity) {
+        return NULL;
+    }
+    return &tables[process_id];
+}
+
+// xorshift32; never returns 0 for a non-zero state
+static uint32_t next_random(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static float next_uniform(uint32_t* state) {
+    return (next_random(state) >> 8) / (float)(1 << 24);
+}
+
+bool paging_add(int process_id, size_t size) {
+    page_table_t* table = table_of(process_id);
+    if (table == NULL) {
+        return false;
+    }
+    int pages = (size + config.page_size - 1) / config.page_size;
+    if (pages < 1) {
+        pages = 1;
+    }
+    free(table->frames);
+    table->frames = malloc(sizeof(int) * pages);
+    if (!table->frames) {
+        perror("Failed to allocate page table");
+        return false;
+    }
+    for (int page = 0; page < pages; page++) {
+        table->frames[page] = -1;
+    }
+    table->pages = pages;
+
+    table->random = (uint32_t)process_id * 2654435761u | 1;
+    table->ws_size = pages * (0.2f + 0.3f * next_uniform(&table->random));
+    if (table->ws_size < 1) {
+        table->ws_size = 1;
+    }
+    table->locality = 0.85f + 0.13f * next_uniform(&table->random);
+    table->write_ratio = 0.1f + 0.3f * next_uniform(&table->random);
+    table->phase_length = config.refs_per_tick * (2 + next_random(&table->random) % 7);
+    table->phase_left = 0;
+    memset(&table->stats, 0, sizeof(table->stats));
+    return true;
+}
+
+static void list_remove(int k) {
+    frame_t* f = &frames[k];
+    if (f->prev != -1) {
+        frames[f->prev].next = f->next;
+    } else {
+        list_head = f->next;
+    }
+    if (f->next != -1) {
+        frames[f->next].prev = f->prev;
+    } else {
+        list_tail = f->prev;
+    }
+}
+
+static void list_append(int k) {
+    frames[k].prev = list_tail;
+    frames[k].next = -1;
+    if (list_tail != -1) {
+        frames[list_tail].next = k;
+    } else {
+        list_head = k;
+    }
+    list_tail = k;
+}
+
+static tlb_entry_t* tlb_set(int owner, int page) {
+    uint32_t set = ((uint32_t)page ^ ((uint32_t)owner * 0x9E3779B1u)) % tlb_sets;
+    return &tlb[set * config.tlb_ways];
+}
+
+static void tlb_invalidate(int owner, int page) {
+    tlb_entry_t* set = tlb_set(owner, page);
+    for (int way = 0; way < config.tlb_ways; way++) {
+        if (set[way].owner == owner && set[way].page == page) {
+            set[way].owner = -1;
+            return;
+        }
+    }
+}
+
+// Victim among resident frames; only called when none is free
+static int pick_victim() {
+    switch (config.policy) {
+    case PAGE_POLICY_CLOCK:
+        for (;;) {
+            int k = hand;
+            hand = (hand + 1) % frame_count;
+            if (!frames[k].referenced) {
+                return k;
+            }
+            frames[k].referenced = false;
+        }
+    case PAGE_POLICY_SECOND_CHANCE:
+        // Look for (unreferenced, clean), then (unreferenced, dirty) while clearing reference
+        // bits; after that sweep every frame is unreferenced, so the next round finds one
+        for (;;) {
+            for (int i = 0; i < frame_count; i++) {
+                int k = (hand + i) % frame_count;
+                if (!frames[k].referenced && !frames[k].dirty) {
+                    hand = (k + 1) % frame_count;
+                    return k;
+                }
+            }
+            for (int i = 0; i < frame_count; i++) {
+                int k = (hand + i) % frame_count;
+                if (!frames[k].referenced) {
+                    hand = (k + 1) % frame_count;
+                    return k;
+                }
+                frames[k].referenced = false;
+            }
+        }
+    default:
+        return list_head;
+    }
+}
+
+// Give up frame k, writing its page back if dirty; returns whether it was
+static bool evict(int k) {
+    frame_t* f = &frames[k];
+    tables[f->owner].frames[f->page] = -1;
+    tlb_invalidate(f->owner, f->page);
+    if (config.policy == PAGE_POLICY_FIFO || config.policy == PAGE_POLICY_LRU) {
+        list_remove(k);
+    }
+    bool dirty = f->dirty;
+    f->owner = -1;
+    return dirty;
+}
+
+// Load a page into a frame; returns the frame
+static int fault(int process_id, page_table_t* table, int page) {
+    table->stats.faults++;
+    table->stats.stall_ticks += config.fault_cost;
+
+    int k;
+    if (free_count > 0) {
+        k = free_frames[--free_count];
+    } else {
+        k = pick_victim();
+        if (DEBUG) {
+            printf(ANSI_COLOR_CYAN "[PAGING] Process %d page %d evicts process %d page %d from frame %d\n" ANSI_COLOR_RESET,
+                process_id, page, frames[k].owner, frames[k].page, k);
+        }
+        if (evict(k)) {
+            table->stats.writebacks++;
+            table->stats.stall_ticks += config.fault_cost;
+        }
+    }
+
+    frame_t* f = &frames[k];
+    f->owner = process_id;
+    f->page = page;
+    f->referenced = true;
+    f->dirty = false;
+    if (config.policy == PAGE_POLICY_FIFO || config.policy == PAGE_POLICY_LRU) {
+        list_append(k);
+    }
+    table->frames[page] = k;
+    return k;
+}
+
+static void reference(int process_id, page_table_t* table, int page, bool write) {
+    table->stats.references++;
+    tlb_entry_t* set = tlb_set(process_id, page);
+    int k = -1;
+    for (int way = 0; way < config.tlb_ways; way++) {
+        if (set[way].owner == process_id && set[way].page == page) {
+            table->stats.tlb_hits++;
+            set[way].last_used = ++tlb_clock;
+            k = set[way].frame;
+            break;
+        }
+    }
+
+    if (k == -1) {
+        // Walk the page table, then refill the least recently used way
+        k = table->frames[page];
+        if (k == -1) {
+            k = fault(process_id, table, page);
+        }
+        tlb_entry_t* victim = &set[0];
+        for (int way = 0; way < config.tlb_ways && victim->owner != -1; way++) {
+            if (set[way].owner == -1 || set[way].last_used < victim->last_used) {
+                victim = &set[way];
+            }
+        }
+        victim->owner = process_id;
+        victim->page = page;
+        victim->frame = k;
+        victim->last_used = ++tlb_clock;
+    }
+
+    frames[k].referenced = true;
+    if (write) {
+        frames[k].dirty = true;
+    }
+    if (config.policy == PAGE_POLICY_LRU && k != list_tail) {
+        list_remove(k);
+        list_append(k);
+    }
+}
+
+float paging_run(int process_id, int ticks) {
+    page_table_t* table = table_of(process_id);
+    if (table == NULL || table->frames == NULL || ticks <= 0) {
+        return 0;
+    }
+    float stall_before = table->stats.stall_ticks;
+    long count = (long)ticks * config.refs_per_tick;
+    for (long i = 0; i < count; i++) {
+        if (table->phase_left-- == 0) {
+            table->ws_base = next_random(&table->random) % table->pages;
+            table->phase_left = table->phase_length;
+        }
+        int page;
+        if (next_uniform(&table->random) < table->locality) {
+            page = (table->ws_base + next_random(&table->random) % table->ws_size) % table->pages;
+        } else {
+            page = next_random(&table->random) % table->pages;
+        }
+        reference(process_id, table, page, next_uniform(&table->random) < table->write_ratio);
+    }
+    return table->stats.stall_ticks - stall_before;
+}
+
+void paging_release(int process_id) {
+    page_table_t* table = table_of(process_id);
+    if (table == NULL || table->frames == NULL) {
+        return;
+    }
+    for (int page = 0; page < table->pages; page++) {
+        int k = table->frames[page];
+        if (k == -1) {
+            continue;
+        }
+        tlb_invalidate(process_id, page);
+        if (config.policy == PAGE_POLICY_FIFO || config.policy == PAGE_POLICY_LRU) {
+            list_remove(k);
+        }
+        frames[k].owner = -1;
+        free_frames[free_count++] = k;
+    }
+    // The statistics outlive the table
+    free(table->frames);
+    table->frames = NULL;
+}
+
+bool paging_get_stats(int process_id, paging_stats_t* stats) {
+    page_table_t* table = table_of(process_id);
+    if (table == NULL || table->pages == 0) {
+        return false;
+    }
+    *stats = table->stats;
+    return true;
+}
+
+void paging_get_totals(paging_stats_t* stats) {
+    memset(stats, 0, sizeof(*stats));
+    for (int id = 0; tables != NULL && id < table_capacity; id++) {
+        stats->references += tables[id].stats.references;
+        stats->tlb_hits += tables[id].stats.tlb_hits;
+        stats->faults += tables[id].stats.faults;
+        stats->writebacks += tables[id].stats.writebacks;
+        stats->stall_ticks += tables[id].stats.stall_ticks;
+    }
+}
+
+bool paging_write_report(const char* file_name) {
+    FILE* file = fopen(file_name, "w");
+    if (!file) {
+        perror("Failed to open paging report");
+        return false;
+    }
+    fprintf(file, "#id pages references tlb_hit_rate fault_rate faults writebacks stall_ticks\n");
+    for (int id = 0; tables != NULL && id < table_capacity; id++) {
+        page_table_t* table = &tables[id];
+        if (table->pages == 0) {
+            continue;
+        }
+        long references = table->stats.references;
+        fprintf(file, "%d %d %ld %.4f %.4f %ld %ld %.2f\n", id, table->pages, references,
+            references > 0 ? (float)table->stats.tlb_hits / references : 0.0f,
+            references > 0 ? (float)table->stats.faults / references : 0.0f,
+            table->stats.faults, table->stats.writebacks, table->stats.stall_ticks);
+    }
+    fclose(file);
+    return true;
+}
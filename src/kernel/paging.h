@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef enum {
+    PAGE_POLICY_FIFO,           // Evict the page loaded longest ago
+    PAGE_POLICY_LRU,            // Evict the page referenced longest ago
+    PAGE_POLICY_CLOCK,          // Sweep the frames, sparing referenced pages once
+    PAGE_POLICY_SECOND_CHANCE,  // Clock over (referenced, dirty) classes: clean unreferenced pages go first
+    PAGE_POLICY_COUNT
+} page_policy_t;
+
+typedef struct paging_config {
+    page_policy_t policy;
+    size_t memory_size;         // Physical memory; memory_size / page_size frames
+    size_t page_size;           // Power of 2
+    int tlb_entries;
+    int tlb_ways;               // Associativity; tlb_entries / tlb_ways sets
+    int refs_per_tick;          // Page references a running process makes per tick
+    float fault_cost;           // Ticks to load a page, and again to write back a dirty victim
+} paging_config_t;
+
+typedef struct paging_stats {
+    long references;
+    long tlb_hits;
+    long faults;
+    long writebacks;            // Dirty pages written back on eviction
+    float stall_ticks;          // CPU time spent servicing faults
+} paging_stats_t;
+
+// Set up frames, the TLB and a page table for each process ID up to max_process_id, before
+// forking; without it every call below is a no-op
+bool paging_init(const paging_config_t* config, int max_process_id);
+bool paging_enabled();
+void paging_destroy();
+const char* page_policy_name(page_policy_t policy);
+int parse_page_policy(const char* name);
+
+bool paging_add(int process_id, size_t size);   // Give the process an empty page table
+// Replay the references of `ticks` ticks of running; returns the fault stall they cost
+float paging_run(int process_id, int ticks);
+void paging_release(int process_id);            // The process finished: free its frames
+bool paging_get_stats(int process_id, paging_stats_t* stats);  // False if the ID has no page table
+void paging_get_totals(paging_stats_t* stats);
+bool paging_write_report(const char* file_name);    // One line per process with a page table
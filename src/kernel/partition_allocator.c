@@ -0,0 +1,262 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "allocator.h"
+#include "colors.h"
+#include "../data_structures/extent_tree.h"
+
+/*
+ * Variable partitioning:
+    * 1. Requests are rounded up to whole min blocks and carved from the front of a free
+    *    extent; the rest of the extent stays free. Nothing else is lost to rounding.
+    * 2. Free extents sit in an extent tree ordered by offset, augmented with the largest
+    *    extent in every subtree, and also ordered by (size, offset).
+    * 3. First fit takes the lowest-offset extent that fits, descending only into subtrees
+    *    whose largest extent is big enough. Next fit does the same from the end of the
+    *    previous allocation and wraps around once. Best fit takes the lower bound of the
+    *    request in the size order.
+    * 4. Segregated fit also links every free extent into a list for its size class,
+    *    floor(log2(size)). It scans the request's own class for a fit, then takes the head
+    *    of the next non-empty class, where every extent is large enough.
+    * 5. A freed extent coalesces with its neighbours at either end, so free extents never
+    *    touch. Allocations are kept in a second tree by offset to find their size.
+*/
+
+#define PARTITION_CLASSES 64
+
+typedef struct partition {
+    alloc_policy_t policy;
+    size_t size;                            // Arena size in bytes
+    size_t min_block;
+    extent_tree_t* free_extents;
+    extent_tree_t* allocations;             // Allocated extents, by offset
+    size_t cursor;                          // Next fit: end of the last allocation
+    extent_t* classes[PARTITION_CLASSES];   // Segregated fit: free extents by size class
+    uint64_t nonempty;                      // Bit k set while classes[k] has an extent
+} partition_t;
+
+static inline int size_class(size_t size) {
+    return 63 - __builtin_clzl(size);
+}
+
+static void class_link(partition_t* self, extent_t* extent) {
+    if (self->policy != ALLOC_POLICY_SEGREGATED_FIT) {
+        return;
+    }
+    int k = size_class(extent->size);
+    extent->prev = NULL;
+    extent->next = self->classes[k];
+    if (extent->next) {
+        extent->next->prev = extent;
+    }
+    self->classes[k] = extent;
+    self->nonempty |= 1ull << k;
+}
+
+static void class_unlink(partition_t* self, extent_t* extent) {
+    if (self->policy != ALLOC_POLICY_SEGREGATED_FIT) {
+        return;
+    }
+    int k = size_class(extent->size);
+    if (extent->prev) {
+        extent->prev->next = extent->next;
+    } else {
+        self->classes[k] = extent->next;
+    }
+    if (extent->next) {
+        extent->next->prev = extent->prev;
+    }
+    if (self->classes[k] == NULL) {
+        self->nonempty &= ~(1ull << k);
+    }
+}
+
+static inline size_t round_size(partition_t* self, size_t size) {
+    if (size < 1) size = 1;
+    return (size + self->min_block - 1) & ~(self->min_block - 1);
+}
+
+static extent_t* find_extent(partition_t* self, size_t need) {
+    extent_t* extent = NULL;
+    switch (self->policy) {
+    case ALLOC_POLICY_FIRST_FIT:
+        return extent_tree_first_fit(self->free_extents, need, 0);
+    case ALLOC_POLICY_NEXT_FIT:
+        extent = extent_tree_first_fit(self->free_extents, need, self->cursor);
+        return extent ? extent : extent_tree_first_fit(self->free_extents, need, 0);
+    case ALLOC_POLICY_BEST_FIT:
+        return extent_tree_best_fit(self->free_extents, need);
+    case ALLOC_POLICY_SEGREGATED_FIT: {
+        int k = size_class(need);
+        for (extent = self->classes[k]; extent; extent = extent->next) {
+            if (extent->size >= need) {
+                return extent;
+            }
+        }
+        uint64_t larger = k + 1 < PARTITION_CLASSES ? self->nonempty >> (k + 1) << (k + 1) : 0;
+        return larger ? self->classes[__builtin_ctzll(larger)] : NULL;
+    }
+    default:
+        return NULL;
+    }
+}
+
+// Return [offset, offset + size) to the free extents, merging with its neighbours
+static int release_extent(partition_t* self, size_t offset, size_t size) {
+    extent_t* prev = extent_tree_prev(self->free_extents, offset);
+    extent_t* next = extent_tree_next(self->free_extents, offset);
+    if (next && next->offset == offset + size) {
+        size += next->size;
+        class_unlink(self, next);
+        extent_tree_remove(self->free_extents, next);
+    }
+    if (prev && prev->offset + prev->size == offset) {
+        class_unlink(self, prev);
+        extent_tree_update(self->free_extents, prev, prev->offset, prev->size + size);
+        class_link(self, prev);
+        return 0;
+    }
+    extent_t* extent = extent_tree_insert(self->free_extents, offset, size);
+    if (!extent) {
+        perror("Failed to allocate free extent");
+        return -1;
+    }
+    class_link(self, extent);
+    return 0;
+}
+
+static long partition_alloc(void* impl, size_t size, unsigned flags) {
+    partition_t* self = impl;
+    (void)flags;    // Extents are always exact in min blocks
+
+    size_t need = round_size(self, size);
+    extent_t* extent = need <= self->size ? find_extent(self, need) : NULL;
+    if (!extent) {
+        if (DEBUG) {
+            printf(ANSI_COLOR_RED "[PARTITION] No free extent of %zu bytes (largest %zu)\n" ANSI_COLOR_RESET,
+                need, extent_tree_largest(self->free_extents));
+        }
+        return -1;
+    }
+
+    size_t offset = extent->offset;
+    if (!extent_tree_insert(self->allocations, offset, need)) {
+        perror("Failed to record allocation");
+        return -1;
+    }
+    class_unlink(self, extent);
+    if (extent->size == need) {
+        extent_tree_remove(self->free_extents, extent);
+    } else {
+        extent_tree_update(self->free_extents, extent, offset + need, extent->size - need);
+        class_link(self, extent);
+    }
+    self->cursor = offset + need;
+
+    if (DEBUG) {
+        printf(ANSI_COLOR_CYAN "[PARTITION] Allocated %zu bytes at offset %zu (%zu free extents)\n"
+            ANSI_COLOR_RESET, need, offset, self->free_extents->count);
+    }
+    return (long)offset;
+}
+
+static int partition_free(void* impl, long offset) {
+    partition_t* self = impl;
+    extent_t* allocation = offset < 0 ? NULL : extent_tree_find(self->allocations, offset);
+    if (!allocation) {
+        if (DEBUG) {
+            printf(ANSI_COLOR_RED "[PARTITION] No allocation starts at offset %ld\n" ANSI_COLOR_RESET, offset);
+        }
+        return -1;
+    }
+    size_t size = allocation->size;
+    extent_tree_remove(self->allocations, allocation);
+    return release_extent(self, offset, size);
+}
+
+static size_t partition_alloc_size(void* impl, long offset) {
+    partition_t* self = impl;
+    extent_t* allocation = offset < 0 ? NULL : extent_tree_find(self->allocations, offset);
+    return allocation ? allocation->size : 0;
+}
+
+static void partition_stats(void* impl, allocator_stats_t* stats) {
+    partition_t* self = impl;
+    stats->total_bytes = self->size;
+    stats->free_bytes = self->free_extents->total_size;
+    stats->largest_free = extent_tree_largest(self->free_extents);
+    stats->free_extents = self->free_extents->count;
+}
+
+// Every policy finds a fit whenever any extent is large enough
+static bool partition_can_fit(void* impl, size_t size, unsigned flags) {
+    partition_t* self = impl;
+    (void)flags;
+    return round_size(self, size) <= extent_tree_largest(self->free_extents);
+}
+
+// The new space is one more free extent; there are no roots to keep apart
+static int partition_grow(void* impl, size_t new_size, bool independent_roots) {
+    partition_t* self = impl;
+    (void)independent_roots;
+    new_size &= ~(self->min_block - 1);
+    if (new_size <= self->size) {
+        return -1;
+    }
+    if (release_extent(self, self->size, new_size - self->size) == -1) {
+        return -1;
+    }
+    self->size = new_size;
+    return 0;
+}
+
+static size_t partition_metadata_size(void* impl) {
+    partition_t* self = impl;
+    return sizeof(partition_t) + 2 * sizeof(extent_tree_t)
+        + (self->free_extents->count + self->allocations->count) * sizeof(extent_t);
+}
+
+static void partition_destroy(void* impl) {
+    partition_t* self = impl;
+    if (self == NULL) {
+        return;
+    }
+    destroy_extent_tree(self->free_extents);
+    destroy_extent_tree(self->allocations);
+    free(self);
+}
+
+static const allocator_ops_t partition_ops = {
+    .alloc = partition_alloc,
+    .free = partition_free,
+    .alloc_size = partition_alloc_size,
+    .stats = partition_stats,
+    .can_fit = partition_can_fit,
+    .grow = partition_grow,
+    .metadata_size = partition_metadata_size,
+    .destroy = partition_destroy,
+};
+
+void* partition_policy_create(alloc_policy_t policy, size_t memory_size, size_t min_block,
+                              const allocator_ops_t** ops) {
+    if (min_block == 0 || (min_block & (min_block - 1)) || memory_size < min_block) {
+        return NULL;
+    }
+
+    partition_t* self = calloc(1, sizeof(partition_t));
+    if (!self) {
+        return NULL;
+    }
+    self->policy = policy;
+    self->size = memory_size & ~(min_block - 1);
+    self->min_block = min_block;
+    self->free_extents = create_extent_tree();
+    self->allocations = create_extent_tree();
+    if (!self->free_extents || !self->allocations || release_extent(self, 0, self->size) == -1) {
+        partition_destroy(self);
+        return NULL;
+    }
+
+    *ops = &partition_ops;
+    return self;
+}
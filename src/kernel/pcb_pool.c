@@ -0,0 +1,126 @@
+#include "pcb_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Thread slots [from, to) onto the front of the free list in ascending order
+static void pcb_pool_link_free(pcb_pool_t* pool, uint32_t from, uint32_t to)
+{
+    for (uint32_t i = to; i > from; i--)
+    {
+        pool->next_free[i - 1] = pool->free_head;
+        pool->free_head = i - 1;
+    }
+}
+
+// Resize one column of the table, leaving it untouched on failure
+static int pcb_pool_resize(void** column, size_t elem_size, uint32_t capacity)
+{
+    void* resized = realloc(*column, elem_size * capacity);
+    if (!resized)
+        return -1;
+    *column = resized;
+    return 0;
+}
+
+static int pcb_pool_reserve(pcb_pool_t* pool, uint32_t capacity)
+{
+    if (pcb_pool_resize((void**)&pool->remaining_time, sizeof(int), capacity) == -1 ||
+        pcb_pool_resize((void**)&pool->priority, sizeof(int), capacity) == -1 ||
+        pcb_pool_resize((void**)&pool->arrival_time, sizeof(int), capacity) == -1 ||
+        pcb_pool_resize((void**)&pool->status, sizeof(uint8_t), capacity) == -1 ||
+        pcb_pool_resize((void**)&pool->cold, sizeof(pcb_cold_t), capacity) == -1 ||
+        pcb_pool_resize((void**)&pool->next_free, sizeof(uint32_t), capacity) == -1)
+        return -1;
+    return 0;
+}
+
+static int pcb_pool_grow(pcb_pool_t* pool)
+{
+    uint32_t new_capacity = pool->capacity * 2;
+    if (new_capacity <= pool->capacity || new_capacity == PCB_SLOT_NONE)
+        return -1;
+
+    if (pcb_pool_reserve(pool, new_capacity) == -1)
+        return -1;
+
+    pcb_pool_link_free(pool, pool->capacity, new_capacity);
+    pool->capacity = new_capacity;
+    return 0;
+}
+
+pcb_pool_t* pcb_pool_create(uint32_t capacity)
+{
+    if (capacity < 1) capacity = 1;
+
+    pcb_pool_t* pool = calloc(1, sizeof(pcb_pool_t));
+    if (!pool)
+        return NULL;
+
+    if (pcb_pool_reserve(pool, capacity) == -1)
+    {
+        pcb_pool_destroy(pool);
+        return NULL;
+    }
+
+    pool->capacity = capacity;
+    pool->used = 0;
+    pool->free_head = PCB_SLOT_NONE;
+    pcb_pool_link_free(pool, 0, capacity);
+    return pool;
+}
+
+uint32_t pcb_pool_alloc(pcb_pool_t* pool)
+{
+    if (pool->free_head == PCB_SLOT_NONE && pcb_pool_grow(pool) == -1)
+    {
+        perror("Failed to grow PCB pool");
+        return PCB_SLOT_NONE;
+    }
+
+    uint32_t slot = pool->free_head;
+    pool->free_head = pool->next_free[slot];
+    pool->used++;
+    return slot;
+}
+
+void pcb_pool_store(pcb_pool_t* pool, uint32_t slot, const PCB* pcb)
+{
+    pool->remaining_time[slot] = pcb->remaining_time;
+    pool->priority[slot] = pcb->priority;
+    pool->arrival_time[slot] = pcb->arrival_time;
+    pool->status[slot] = (uint8_t)pcb->status;
+
+    pcb_cold_t* cold = &pool->cold[slot];
+    cold->id = pcb->id;
+    cold->pid = pcb->pid;
+    cold->runtime = pcb->runtime;
+    cold->waiting_time = pcb->waiting_time;
+    cold->start_time = pcb->start_time;
+    cold->last_run_time = pcb->last_run_time;
+    cold->finish_time = pcb->finish_time;
+    cold->response_time = pcb->response_time;
+    cold->turnaround_time = pcb->turnaround_time;
+    cold->weighted_turnaround = pcb->weighted_turnaround;
+}
+
+void pcb_pool_free(pcb_pool_t* pool, uint32_t slot)
+{
+    if (slot >= pool->capacity)
+        return;
+    pool->next_free[slot] = pool->free_head;
+    pool->free_head = slot;
+    pool->used--;
+}
+
+void pcb_pool_destroy(pcb_pool_t* pool)
+{
+    if (!pool)
+        return;
+    free(pool->remaining_time);
+    free(pool->priority);
+    free(pool->arrival_time);
+    free(pool->status);
+    free(pool->cold);
+    free(pool->next_free);
+    free(pool);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include "pcb.h"
+
+#define PCB_SLOT_NONE UINT32_MAX
+
+// Per-process fields the scheduler only touches at dispatch, stop and exit
+typedef struct {
+    int id;
+    int pid;
+    int runtime;
+    int waiting_time;
+    int start_time;
+    int last_run_time;
+    int finish_time;
+    int response_time;
+    int turnaround_time;
+    float weighted_turnaround;
+} pcb_cold_t;
+
+/*
+ * Slab of PCBs addressed by 32-bit slot index.
+ * The keys read on every scheduling decision (heap comparisons, preemption
+ * checks) are kept as parallel arrays so scans only pull those into cache;
+ * everything else sits in the cold array. PCB remains the IPC format and is
+ * scattered into the table by pcb_pool_store().
+ * Freed slots are threaded onto a free list and reused before the slab grows,
+ * so once the working set has been reached admitting and retiring processes
+ * does no heap traffic. Growth may move the arrays: hold slot indices, not
+ * pointers, across anything that can admit a process, and block any signal
+ * whose handler touches the pool across pcb_pool_alloc().
+ */
+typedef struct {
+    // Hot scheduling keys
+    int* remaining_time;
+    int* priority;
+    int* arrival_time;
+    uint8_t* status;
+
+    // Cold bookkeeping
+    pcb_cold_t* cold;
+
+    uint32_t* next_free;  // Free list links, indexed by slot
+    uint32_t free_head;
+    uint32_t capacity;
+    uint32_t used;
+} pcb_pool_t;
+
+pcb_pool_t* pcb_pool_create(uint32_t capacity);
+uint32_t pcb_pool_alloc(pcb_pool_t* pool);
+void pcb_pool_store(pcb_pool_t* pool, uint32_t slot, const PCB* pcb);
+void pcb_pool_free(pcb_pool_t* pool, uint32_t slot);
+void pcb_pool_destroy(pcb_pool_t* pool);
@@ -12,74 +12,285 @@
 #include <sys/wait.h>
 #include "colors.h"
 #include "memory_manager.h"
+#include "swapper.h"
+#include "paging.h"
+#include "timer_wheel.h"
 
 #include "scheduler.h"
-#include <bits/getopt_core.h>
+#include <getopt.h>
 int scheduler_type = -1; // Default invalid value
 char* process_file = "processes.txt"; // Default filename
 int quantum = 2; // Default quantum value
-processParameters** process_parameters;
+float context_switch_cost = 0; // Ticks charged per context switch (may be fractional)
+float cache_refill_penalty = 0; // Extra ticks charged when resuming a stopped process
+processParameters* process_parameters;
 int msgid;
 key_t key;
 int remaining_processes;
 
-// Memory size for the buddy system (adjust as needed)
+// Default memory size and minimum block for the buddy system, in bytes
 #define MEMORY_SIZE 1024
+#define MIN_BLOCK_SIZE 1
+size_t memory_size = MEMORY_SIZE;
+size_t min_block_size = MIN_BLOCK_SIZE;
+int trim_allocations = 0; // Give the unused tail of each rounded block back to the buddy
+alloc_policy_t memory_policy = ALLOC_POLICY_BUDDY; // Allocator behind the memory manager
+admission_policy_t admission_policy = ADMIT_SMALLEST_FIRST; // Order the waiting list is admitted in
+int swap_policy = -1; // Evict ready processes to the swap device when memory runs out (-1: off)
+float swap_cost = 1; // Ticks to move one KiB to or from the swap device
+
+// Memory split into arenas (-A size[:policy],...); arenas without a policy use -p's
+const char* arena_list = NULL;
+arena_spec_t arena_specs[MAX_ARENAS];
+int arena_count = 0;
+placement_policy_t placement_policy = PLACEMENT_LOCAL_FIRST;
+int arena_locks = 0; // One mutex per arena
+
+// Paged virtual memory (-V policy): processes are admitted without contiguous memory and
+// demand-page into memory_size / page_size frames, simulated by the scheduler
+int paging_policy = -1;
+size_t page_size = 16;
+int tlb_entries = 16;
+int tlb_ways = 4;
+int refs_per_tick = 100;
+float fault_cost = 0.02; // Ticks per page loaded or written back
+
+// Memory hot-add events (-g tick:size[:root]), fired from the arrival wheel
+#define MAX_GROW_EVENTS 8
+typedef struct {
+    int tick;
+    size_t size;
+    bool independent_roots;   // Add separate roots instead of doubling the existing one
+    tw_timer_t timer;
+} grow_event_t;
+grow_event_t grow_events[MAX_GROW_EVENTS];
+int grow_event_count = 0;
+
+// The scheduler's PID; simulated processes signal it when they finish
+pid_t process_generator_pid;
+
+// Pending arrivals, one timer per process, fired as the clock reaches them
+timer_wheel_t* arrival_wheel = NULL;
+tw_timer_t* arrival_timers = NULL;
+
+// Arrivals fired during the current tick, admitted to memory together as one batch
+processParameters** arrival_batch = NULL;
+mm_request_t* arrival_requests = NULL;
+long* arrival_offsets = NULL;
+int arrival_batch_count = 0;
+int messages_sent = 0;
+
+// Fork the simulated process for `proc` and hand its PCB to the scheduler. Its memory
+// is either held under `token` and committed once the PID is known, or, with
+// MM_NO_TOKEN, already allocated by process ID
+static int launch_process(processParameters* proc, mm_token_t token) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        char runtime_str[16];
+        snprintf(runtime_str, sizeof(runtime_str), "%d", proc->runtime);
+        char pid_str[16];
+        snprintf(pid_str, sizeof(pid_str), "%d", process_generator_pid);
+        execl("./process", "process", runtime_str, pid_str, (char*)NULL);
+        perror("execl failed");
+        exit(1);
+    } else if (pid < 0) {
+        perror("fork failed");
+        // Give the memory back since forking failed
+        if (token != MM_NO_TOKEN)
+            mm_cancel(token);
+        else
+            mm_free_by_id(proc->id);
+        return -1;
+    }
+
+    proc->pid = pid;
+    // Establish bidirectional mapping between PID and process ID
+    if (token != MM_NO_TOKEN)
+    {
+        // The process is already running; without a record its memory is given back
+        if (!mm_commit(token, proc->id, pid))
+            fprintf(stderr, "[PROC_GENERATOR] Process ID %d runs without memory: its reservation could not be committed\n", proc->id);
+    }
+    else
+        mm_map_pid_to_id(pid, proc->id);
+    mm_project_release(proc->id, proc->runtime);
+
+    PCB proc_pcb = {
+        1, proc->id, pid,
+        proc->arrival_time, proc->runtime,
+        proc->runtime, proc->priority, 0, -1, -1, -1, -1, -1,
+        -1,
+        READY,
+    };
+    swapper_admit(proc->id, proc->memsize);
+    if (msgsnd(msgid, &proc_pcb, sizeof(PCB), 0) == -1) {
+        if (DEBUG)
+            perror("Error sending message");
+    }
+    messages_sent++;
+    return 0;
+}
 
 // Function to check and process waiting list
 void process_waiting_list() {
     while (mm_has_waiting_processes()) {
-        processParameters* proc = mm_get_next_allocatable_process();
+        // Swap ready processes out until the next one fits, if swapping is on
+        if (swapper_enabled() && !swapper_make_room(mm_get_next_waiting_size()))
+            break;
+        // The memory is reserved before the process leaves the waiting list, so nothing
+        // can take it between this check and the fork
+        mm_token_t token;
+        processParameters* proc = mm_get_next_allocatable_process(&token);
         if (!proc) break;
         if (DEBUG) printf(ANSI_COLOR_MAGENTA"[PROC_GENERATOR] Processing waiting process ID %d\n" ANSI_COLOR_RESET, proc->id);
-        
-        // Attempt to allocate memory first - with a temporary ID
-        int allocation = mm_allocate(proc->id, proc->memsize);
-        if (allocation == -1) {
-            // If allocation failed, put back in the waiting list
-            if (DEBUG) printf(ANSI_COLOR_MAGENTA"[PROC_GENERATOR] Still can't allocate memory for process ID %d, keeping in waiting list\n" ANSI_COLOR_RESET, proc->id);
+
+        if (launch_process(proc, token) == 0 && DEBUG)
+            printf(ANSI_COLOR_MAGENTA"[PROC_GENERATOR] Started waiting process ID %d with PID %d\n" ANSI_COLOR_RESET, proc->id, proc->pid);
+        free(proc);
+    }
+}
+
+// Parse a byte count with an optional K, M or G (binary) suffix; returns 0 if invalid
+static size_t parse_size(const char* text) {
+    char* end;
+    unsigned long long value = strtoull(text, &end, 10);
+    switch (*end) {
+    case 'G': case 'g': value <<= 10; // fall through
+    case 'M': case 'm': value <<= 10; // fall through
+    case 'K': case 'k': value <<= 10; end++; break;
+    default: break;
+    }
+    if (end == text || *end != '\0') {
+        return 0;
+    }
+    return (size_t)value;
+}
+
+// Parse "size[:policy],..." into arena_specs; returns -1 if invalid
+static int parse_arena_specs(const char* text) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    arena_count = 0;
+    char* saveptr;
+    for (char* item = strtok_r(buffer, ",", &saveptr); item != NULL; item = strtok_r(NULL, ",", &saveptr)) {
+        if (arena_count == MAX_ARENAS)
+            return -1;
+        char* policy_text = strchr(item, ':');
+        if (policy_text != NULL)
+            *policy_text++ = '\0';
+
+        size_t size = parse_size(item);
+        int policy = policy_text != NULL ? parse_alloc_policy(policy_text) : (int)memory_policy;
+        if (size == 0 || policy == -1)
+            return -1;
+        arena_specs[arena_count].size = size;
+        arena_specs[arena_count].policy = policy;
+        arena_count++;
+    }
+    return arena_count > 0 ? 0 : -1;
+}
+
+// Parse "entries[:ways]"; returns -1 if invalid
+static int parse_tlb(const char* text) {
+    char* end;
+    long entries = strtol(text, &end, 10);
+    long ways = entries;
+    if (*end == ':') {
+        char* ways_text = end + 1;
+        ways = strtol(ways_text, &end, 10);
+        if (end == ways_text)
+            return -1;
+    }
+    if (end == text || *end != '\0' || entries < 1 || ways < 1 || entries % ways)
+        return -1;
+    tlb_entries = (int)entries;
+    tlb_ways = (int)ways;
+    return 0;
+}
+
+// Arrival timer callback: queue the process for this tick's admission batch
+static void on_arrival(tw_timer_t* timer, void* arg) {
+    processParameters* proc = (processParameters*)arg;
+    remaining_processes--;
+    arrival_batch[arrival_batch_count++] = proc;
+}
+
+// Allocate memory for every process that arrived this tick in one batch; launch the ones
+// that fit, in arrival order, and park the rest in the waiting list
+static void admit_arrivals() {
+    if (arrival_batch_count == 0)
+        return;
+
+    // Paged processes need no contiguous memory; their pages are loaded as they run
+    if (paging_enabled()) {
+        for (int i = 0; i < arrival_batch_count; i++)
+            launch_process(arrival_batch[i], MM_NO_TOKEN);
+        arrival_batch_count = 0;
+        return;
+    }
+
+    for (int i = 0; i < arrival_batch_count; i++) {
+        arrival_requests[i].process_id = arrival_batch[i]->id;
+        arrival_requests[i].size = arrival_batch[i]->memsize;
+    }
+    mm_allocate_batch(arrival_requests, arrival_batch_count, arrival_offsets);
+
+    for (int i = 0; i < arrival_batch_count; i++) {
+        processParameters* proc = arrival_batch[i];
+        if (arrival_offsets[i] == -1) {
+            // Memory allocation failed, add to waiting list
+            if (DEBUG)
+                printf(ANSI_COLOR_MAGENTA"[PROC_GENERATOR] Cannot allocate memory for process ID %d, adding to waiting list\n" ANSI_COLOR_RESET, proc->id);
             mm_add_to_waiting_list(proc);
-            free(proc);
-            break; // Break from the loop since memory is still constrained
+            continue;
         }
-        
+
         // Memory allocation succeeded, now fork
-        pid_t pid = fork();
-        if (pid == 0) {
-            char runtime_str[16];
-            snprintf(runtime_str, sizeof(runtime_str), "%d", proc->runtime);
-            char pid_str[16];
-            snprintf(pid_str, sizeof(pid_str), "%d", getpid());
-            execl("./process", "process", runtime_str, pid_str, (char*)NULL);
-            perror("execl failed");
-            exit(1);
-        } else if (pid > 0) {
-            proc->pid = pid;
-            // Establish bidirectional mapping between PID and process ID
-            mm_map_pid_to_id(pid, proc->id);
-            
-            if (allocation != -1) {
-                if (DEBUG)
-                    printf(ANSI_COLOR_MAGENTA"[PROC_GENERATOR] Started waiting process ID %d with PID %d\n" ANSI_COLOR_RESET, proc->id, pid);
-                PCB proc_pcb = {
-                    1, proc->id, pid,
-                    proc->arrival_time, proc->runtime,
-                    proc->runtime, proc->priority, 0, -1, -1, -1, -1, -1,
-                    -1,
-                    READY,
-                };
-                if (msgsnd(msgid, &proc_pcb, sizeof(PCB), 0) == -1) {
-                    if (DEBUG)
-                        perror("Error sending message");
-                }
-            }
-        } else {
-            perror("fork failed");
-            // Free the allocation since forking failed
-            mm_free_by_id(proc->id);
-        }
-        free(proc);
+        if (launch_process(proc, MM_NO_TOKEN) == 0 && DEBUG)
+            printf(ANSI_COLOR_MAGENTA"[PROC_GENERATOR] Allocated memory at offset %ld for PID %d\n" ANSI_COLOR_RESET, arrival_offsets[i], proc->pid);
     }
+    arrival_batch_count = 0;
+}
+
+// Grow timer callback: hot-add memory, then let waiting processes use it straight away
+static void on_grow(tw_timer_t* timer, void* arg) {
+    grow_event_t* event = (grow_event_t*)arg;
+    if (!mm_grow(event->size, event->independent_roots)) {
+        fprintf(stderr, "[PROC_GENERATOR] Could not grow memory to %zu bytes at time %d\n", event->size, event->tick);
+        return;
+    }
+    if (DEBUG)
+        printf(ANSI_COLOR_MAGENTA"[PROC_GENERATOR] Memory grown to %zu bytes, re-examining %d waiting process(es)\n"
+            ANSI_COLOR_RESET, event->size, mm_get_waiting_count());
+    process_waiting_list();
+}
+
+// Parse "tick:size[:root]" into the next grow event; returns 0, or -1 if malformed
+static int parse_grow_event(const char* text) {
+    if (grow_event_count == MAX_GROW_EVENTS)
+        return -1;
+
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    char* size_text = strchr(buffer, ':');
+    if (size_text == NULL)
+        return -1;
+    *size_text++ = '\0';
+    char* mode = strchr(size_text, ':');
+    if (mode != NULL)
+        *mode++ = '\0';
+
+    char* end;
+    long tick = strtol(buffer, &end, 10);
+    size_t size = parse_size(size_text);
+    if (end == buffer || *end != '\0' || tick < 0 || size == 0 || (mode != NULL && strcmp(mode, "root") != 0))
+        return -1;
+
+    grow_event_t* event = &grow_events[grow_event_count++];
+    event->tick = (int)tick;
+    event->size = size;
+    event->independent_roots = mode != NULL;
+    return 0;
 }
 
 int main(int argc, char* argv[])
@@ -87,8 +298,29 @@ int main(int argc, char* argv[])
     int process_count;
 
     // Parse command line arguments
+    static struct option long_options[] = {
+        {"switch-cost", required_argument, NULL, 'c'},
+        {"refill-cost", required_argument, NULL, 'r'},
+        {"memory", required_argument, NULL, 'm'},
+        {"min-block", required_argument, NULL, 'b'},
+        {"trim", no_argument, NULL, 't'},
+        {"grow", required_argument, NULL, 'g'},
+        {"mem-policy", required_argument, NULL, 'p'},
+        {"admission", required_argument, NULL, 'a'},
+        {"swap", required_argument, NULL, 'w'},
+        {"swap-cost", required_argument, NULL, 'W'},
+        {"arenas", required_argument, NULL, 'A'},
+        {"placement", required_argument, NULL, 'P'},
+        {"arena-locks", no_argument, NULL, 'L'},
+        {"paging", required_argument, NULL, 'V'},
+        {"page-size", required_argument, NULL, 'Z'},
+        {"tlb", required_argument, NULL, 'T'},
+        {"refs", required_argument, NULL, 'R'},
+        {"fault-cost", required_argument, NULL, 'F'},
+        {NULL, 0, NULL, 0}
+    };
     int opt;
-    while ((opt = getopt(argc, argv, "s:f:q:")) != -1)
+    while ((opt = getopt_long(argc, argv, "s:f:q:c:r:m:b:tg:p:a:w:W:A:P:LV:Z:T:R:F:", long_options, NULL)) != -1)
     {
         switch (opt)
         {
@@ -121,8 +353,184 @@ int main(int argc, char* argv[])
             quantum = atoi(optarg);
             printf(ANSI_COLOR_MAGENTA"[MAIN] Quantum set to: %d\n"ANSI_COLOR_RESET, quantum);
             break;
+        case 'c':
+            context_switch_cost = atof(optarg);
+            if (context_switch_cost < 0)
+            {
+                fprintf(stderr, "Context switch cost must not be negative\n");
+                exit(EXIT_FAILURE);
+            }
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Context switch cost set to: %.2f ticks\n"ANSI_COLOR_RESET,
+                   context_switch_cost);
+            break;
+        case 'r':
+            cache_refill_penalty = atof(optarg);
+            if (cache_refill_penalty < 0)
+            {
+                fprintf(stderr, "Cache refill penalty must not be negative\n");
+                exit(EXIT_FAILURE);
+            }
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Cache refill penalty set to: %.2f ticks\n"ANSI_COLOR_RESET,
+                   cache_refill_penalty);
+            break;
+        case 'm':
+            memory_size = parse_size(optarg);
+            if (memory_size == 0)
+            {
+                fprintf(stderr, "Invalid memory size: %s\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Memory size set to: %zu bytes\n"ANSI_COLOR_RESET, memory_size);
+            break;
+        case 'b':
+            min_block_size = parse_size(optarg);
+            if (min_block_size == 0 || (min_block_size & (min_block_size - 1)))
+            {
+                fprintf(stderr, "Minimum block size must be a power of 2: %s\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Minimum block size set to: %zu bytes\n"ANSI_COLOR_RESET,
+                   min_block_size);
+            break;
+        case 't':
+            trim_allocations = 1;
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Trimmed memory allocations enabled\n"ANSI_COLOR_RESET);
+            break;
+        case 'g':
+            if (parse_grow_event(optarg) == -1)
+            {
+                fprintf(stderr, "Invalid grow event (expected tick:size[:root], at most %d): %s\n",
+                        MAX_GROW_EVENTS, optarg);
+                exit(EXIT_FAILURE);
+            }
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Memory grows to %zu bytes at time %d\n"ANSI_COLOR_RESET,
+                   grow_events[grow_event_count - 1].size, grow_events[grow_event_count - 1].tick);
+            break;
+        case 'p':
+        {
+            int policy = parse_alloc_policy(optarg);
+            if (policy == -1)
+            {
+                fprintf(stderr, "Invalid memory policy: %s\n", optarg);
+                fprintf(stderr, "Valid options are: buddy, first-fit, next-fit, best-fit, segregated-fit\n");
+                exit(EXIT_FAILURE);
+            }
+            memory_policy = policy;
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Memory policy set to: %s\n"ANSI_COLOR_RESET, optarg);
+            break;
+        }
+        case 'a':
+        {
+            int policy = parse_admission_policy(optarg);
+            if (policy == -1)
+            {
+                fprintf(stderr, "Invalid admission policy: %s\n", optarg);
+                fprintf(stderr, "Valid options are: smallest, fifo, backfill\n");
+                exit(EXIT_FAILURE);
+            }
+            admission_policy = policy;
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Admission policy set to: %s\n"ANSI_COLOR_RESET, optarg);
+            break;
+        }
+        case 'w':
+            if (strcmp(optarg, "lru") == 0)
+            {
+                swap_policy = SWAP_POLICY_LRU;
+            }
+            else if (strcmp(optarg, "largest") == 0)
+            {
+                swap_policy = SWAP_POLICY_LARGEST;
+            }
+            else
+            {
+                fprintf(stderr, "Invalid swap policy: %s\n", optarg);
+                fprintf(stderr, "Valid options are: lru, largest\n");
+                exit(EXIT_FAILURE);
+            }
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Swapping enabled, evicting by: %s\n"ANSI_COLOR_RESET, optarg);
+            break;
+        case 'W':
+            swap_cost = atof(optarg);
+            if (swap_cost < 0)
+            {
+                fprintf(stderr, "Swap cost must not be negative\n");
+                exit(EXIT_FAILURE);
+            }
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Swap cost set to: %.2f ticks per KiB\n"ANSI_COLOR_RESET, swap_cost);
+            break;
+        case 'A':
+            arena_list = optarg; // Parsed once -p is known
+            break;
+        case 'P':
+        {
+            int placement = parse_placement_policy(optarg);
+            if (placement == -1)
+            {
+                fprintf(stderr, "Invalid placement policy: %s\n", optarg);
+                fprintf(stderr, "Valid options are: local, interleave, least-loaded\n");
+                exit(EXIT_FAILURE);
+            }
+            placement_policy = placement;
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Arena placement set to: %s\n"ANSI_COLOR_RESET, optarg);
+            break;
+        }
+        case 'L':
+            arena_locks = 1;
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Per-arena locks enabled\n"ANSI_COLOR_RESET);
+            break;
+        case 'V':
+            paging_policy = parse_page_policy(optarg);
+            if (paging_policy == -1)
+            {
+                fprintf(stderr, "Invalid page replacement policy: %s\n", optarg);
+                fprintf(stderr, "Valid options are: fifo, lru, clock, second-chance\n");
+                exit(EXIT_FAILURE);
+            }
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Paging enabled, replacing by: %s\n"ANSI_COLOR_RESET, optarg);
+            break;
+        case 'Z':
+            page_size = parse_size(optarg);
+            if (page_size == 0 || (page_size & (page_size - 1)))
+            {
+                fprintf(stderr, "Page size must be a power of 2: %s\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Page size set to: %zu bytes\n"ANSI_COLOR_RESET, page_size);
+            break;
+        case 'T':
+            if (parse_tlb(optarg) == -1)
+            {
+                fprintf(stderr, "Invalid TLB (expected entries[:ways], entries a multiple of ways): %s\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            printf(ANSI_COLOR_MAGENTA"[MAIN] TLB set to: %d entries, %d-way\n"ANSI_COLOR_RESET, tlb_entries, tlb_ways);
+            break;
+        case 'R':
+            refs_per_tick = atoi(optarg);
+            if (refs_per_tick < 1)
+            {
+                fprintf(stderr, "References per tick must be positive\n");
+                exit(EXIT_FAILURE);
+            }
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Page references per tick set to: %d\n"ANSI_COLOR_RESET, refs_per_tick);
+            break;
+        case 'F':
+            fault_cost = atof(optarg);
+            if (fault_cost < 0)
+            {
+                fprintf(stderr, "Fault cost must not be negative\n");
+                exit(EXIT_FAILURE);
+            }
+            printf(ANSI_COLOR_MAGENTA"[MAIN] Page fault cost set to: %.3f ticks\n"ANSI_COLOR_RESET, fault_cost);
+            break;
         default:
-            fprintf(stderr, "Usage: %s -s <scheduling-algorithm> -f <processes-text-file> [-q <quantum>]\n", argv[0]);
+            fprintf(stderr, "Usage: %s -s <scheduling-algorithm> -f <processes-text-file> [-q <quantum>]"
+                    " [-c <switch-cost>] [-r <refill-cost>] [-m <memory-size>] [--min-block <bytes>] [--trim]"
+                    " [-g <tick>:<size>[:root]] [--mem-policy <policy>] [--admission <policy>]"
+                    " [--swap <lru|largest>] [--swap-cost <ticks-per-KiB>]"
+                    " [--arenas <size>[:<policy>],...] [--placement <policy>] [--arena-locks]"
+                    " [--paging <policy>] [--page-size <bytes>] [--tlb <entries>[:<ways>]] [--refs <per-tick>]"
+                    " [--fault-cost <ticks>]\n", argv[0]);
             exit(EXIT_FAILURE);
         }
     }
@@ -135,19 +543,78 @@ int main(int argc, char* argv[])
         exit(EXIT_FAILURE);
     }
 
+    if (paging_policy != -1 && swap_policy != -1)
+    {
+        fprintf(stderr, "Paging and swapping cannot be combined: paged processes are never swapped whole\n");
+        exit(EXIT_FAILURE);
+    }
+
     // Get List of processes
     process_parameters = read_process_file(process_file, &process_count);
     remaining_processes = process_count;
 
+    // Arenas replace -m: the memory is their sizes added up
+    if (arena_list != NULL)
+    {
+        if (parse_arena_specs(arena_list) == -1)
+        {
+            fprintf(stderr, "Invalid arenas (expected size[:policy],..., at most %d): %s\n", MAX_ARENAS, arena_list);
+            exit(EXIT_FAILURE);
+        }
+        memory_size = 0;
+        for (int k = 0; k < arena_count; k++)
+            memory_size += arena_specs[k].size;
+        printf(ANSI_COLOR_MAGENTA"[MAIN] Memory split into %d arenas, %zu bytes in all\n"ANSI_COLOR_RESET,
+               arena_count, memory_size);
+    }
+
     // Initialize memory manager
-    if (!mm_init(MEMORY_SIZE)) {
+    bool initialized = arena_list != NULL
+        ? mm_init_arenas(arena_specs, arena_count, min_block_size, placement_policy, arena_locks)
+        : mm_init(memory_size, min_block_size, memory_policy);
+    if (!initialized) {
         fprintf(stderr, "Failed to initialize memory manager\n");
         exit(EXIT_FAILURE);
     }
+    mm_set_trim(trim_allocations);
+    mm_set_admission(admission_policy);
+
+    // The swap table is shared, so it must exist before the scheduler forks off
+    if (swap_policy != -1)
+    {
+        int max_id = 0;
+        for (int i = 0; i < process_count; i++)
+            if (process_parameters[i].id > max_id)
+                max_id = process_parameters[i].id;
+        if (!swapper_init(swap_policy, swap_cost, max_id))
+        {
+            fprintf(stderr, "Failed to initialize swapper\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    // The scheduler runs the paging simulation on the copy it inherits when forked
+    if (paging_policy != -1)
+    {
+        paging_config_t paging_config = {
+            paging_policy, memory_size, page_size, tlb_entries, tlb_ways, refs_per_tick, fault_cost,
+        };
+        int max_id = 0;
+        for (int i = 0; i < process_count; i++)
+            if (process_parameters[i].id > max_id)
+                max_id = process_parameters[i].id;
+        if (!paging_init(&paging_config, max_id))
+        {
+            fprintf(stderr, "Failed to initialize paging (memory must hold at least one page)\n");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < process_count; i++)
+            paging_add(process_parameters[i].id, process_parameters[i].memsize);
+    }
     
     if (DEBUG) {
-        printf(ANSI_COLOR_MAGENTA"[PROC_GENERATOR] Memory manager initialized with size %d\n"ANSI_COLOR_RESET, 
-            MEMORY_SIZE);
+        printf(ANSI_COLOR_MAGENTA"[PROC_GENERATOR] Memory manager initialized with size %zu\n"ANSI_COLOR_RESET, 
+            memory_size);
     }
 
     // Init IPC
@@ -164,7 +631,7 @@ int main(int argc, char* argv[])
      * Fork -> sends the processes at the appropriate time to the scheduler
      * Parent -> runs the clk
      */
-    pid_t process_generator_pid = getpid();
+    process_generator_pid = getpid();
     pid_t clk_pid = fork();
     // Child b
     // Child -> Fork processes and sends their pcb to the scheduler at the appropriate time
@@ -178,87 +645,55 @@ int main(int argc, char* argv[])
             signal(SIGCHLD, child_process_handler);
             sync_clk();
 
-            int remaining_processes = process_count;
             int crt_clk = get_clk();
             int old_clk = -1;
+
+            // Arm one arrival timer per process; each tick only fires those due
+            arrival_wheel = create_timer_wheel(crt_clk);
+            arrival_timers = (tw_timer_t*)malloc((process_count > 0 ? process_count : 1) * sizeof(tw_timer_t));
+            arrival_batch = (processParameters**)malloc((process_count > 0 ? process_count : 1) * sizeof(processParameters*));
+            arrival_requests = (mm_request_t*)malloc((process_count > 0 ? process_count : 1) * sizeof(mm_request_t));
+            arrival_offsets = (long*)malloc((process_count > 0 ? process_count : 1) * sizeof(long));
+            if (!arrival_wheel || !arrival_timers || !arrival_batch || !arrival_requests || !arrival_offsets)
+            {
+                perror("Failed to allocate arrival timers");
+                exit(1);
+            }
+            for (int i = 0; i < process_count; i++)
+            {
+                tw_timer_init(&arrival_timers[i], on_arrival, &process_parameters[i]);
+                timer_wheel_add(arrival_wheel, &arrival_timers[i], process_parameters[i].arrival_time);
+            }
+            for (int i = 0; i < grow_event_count; i++)
+            {
+                tw_timer_init(&grow_events[i].timer, on_grow, &grow_events[i]);
+                timer_wheel_add(arrival_wheel, &grow_events[i].timer, grow_events[i].tick);
+            }
             
+            // SIGCHLD frees memory, so it is held off while a tick allocates
+            sigset_t sigchld_set;
+            sigemptyset(&sigchld_set);
+            sigaddset(&sigchld_set, SIGCHLD);
+
             // Continue running until all processes are processed and waiting list is empty
             while (remaining_processes > 0 || mm_has_waiting_processes())
             {
                 // Ensure that we move by increments of 1
                 while ((crt_clk = get_clk()) - old_clk == 0);
                 old_clk = crt_clk;
+                sigprocmask(SIG_BLOCK, &sigchld_set, NULL);
+
+                // Processes the scheduler is waiting to dispatch come back before new ones are admitted
+                swapper_service(crt_clk);
 
                 // First, try to process waiting list
                 process_waiting_list();
                 
-                int messages_sent = 0;
+                messages_sent = 0;
                 
-                // Check the process_parameters[] for processes whose arrival time == crt_clk
-                for (int i = 0; i < process_count; i++)
-                {
-                    if (process_parameters[i] != NULL && process_parameters[i]->arrival_time == crt_clk)
-                    {
-                        // Try to allocate memory first - with process ID as identifier
-                        int allocation = mm_allocate(process_parameters[i]->id, process_parameters[i]->memsize);
-                        
-                        if (allocation == -1) {
-                            // Memory allocation failed, add to waiting list
-                            if (DEBUG)
-                                printf(ANSI_COLOR_MAGENTA"[PROC_GENERATOR] Cannot allocate memory for process ID %d, adding to waiting list\n" ANSI_COLOR_RESET, process_parameters[i]->id);
-                            mm_add_to_waiting_list(process_parameters[i]);
-                            continue;
-                        }
-                        
-                        // Memory allocation succeeded, now fork
-                        pid_t pid = fork();
-                        if (pid == 0)
-                        {
-                            char runtime_str[16];
-                            snprintf(runtime_str, sizeof(runtime_str), "%d", process_parameters[i]->runtime);
-                            char pid_str[16];
-                            snprintf(pid_str, sizeof(pid_str), "%d", process_generator_pid);
-                            execl("./process", "process", runtime_str, pid_str, (char*)NULL);
-                            perror("execl failed");
-                            exit(1);
-                        }
-                        else if (pid > 0)
-                        {
-                            process_parameters[i]->pid = pid;
-                            // Add mapping between PID and process ID
-                            mm_map_pid_to_id(pid, process_parameters[i]->id);
-                            
-                            if (allocation != -1)
-                            {
-                                if (DEBUG)
-                                    printf(ANSI_COLOR_MAGENTA"[PROC_GENERATOR] Allocated memory at offset %d for PID %d\n" ANSI_COLOR_RESET, allocation, pid);
-                                // Send message to scheduler
-                                messages_sent++;
-                                PCB proc_pcb = {
-                                    1, process_parameters[i]->id, pid,
-                                    process_parameters[i]->arrival_time, process_parameters[i]->runtime,
-                                    process_parameters[i]->runtime, process_parameters[i]->priority, 0, -1, -1, -1, -1, -1,
-                                    -1,
-                                    READY,
-                                };
-                                if (msgsnd(msgid, &proc_pcb, sizeof(PCB), 0) == -1)
-                                {
-                                    if (DEBUG)
-                                        perror("Error sending message");
-                                }
-                            }
-    
-                        }
-                        else
-                        {
-                            perror("fork failed");
-                            // Free the allocation since forking failed
-                            mm_free_by_id(process_parameters[i]->id);
-                        }
-                    }
-                    else if (process_parameters[i] != NULL && process_parameters[i]->arrival_time > crt_clk)
-                        break;
-                }
+                // Fire the arrivals due by now, including any tick the loop skipped over
+                timer_wheel_advance(arrival_wheel, crt_clk);
+                admit_arrivals();
 
                 if (messages_sent > 0 && DEBUG)
                     printf(ANSI_COLOR_MAGENTA"[PROC_GENERATOR] Sent %d message(s) to scheduler\n"ANSI_COLOR_RESET, messages_sent);
@@ -267,6 +702,10 @@ int main(int argc, char* argv[])
                 if (messages_sent > 0) {
                     process_waiting_list();
                 }
+
+                // This tick's memory events, including frees reaped since the last one
+                mm_flush_memory_log();
+                sigprocmask(SIG_UNBLOCK, &sigchld_set, NULL);
                 
                 if (DEBUG && remaining_processes == 0 && mm_has_waiting_processes()) {
                     printf(ANSI_COLOR_MAGENTA"[PROC_GENERATOR] All processes arrived, %d waiting for memory\n"
@@ -295,8 +734,22 @@ int main(int argc, char* argv[])
             
             
             process_generator_cleanup(process_generator_pid);
-            // Make the process generator wait until all children exited
-            while (wait(NULL) > 0);
+            // Make the process generator wait until all children exited; with SIGCHLD held off
+            // they are all reaped here, so their memory is released here too
+            sigprocmask(SIG_BLOCK, &sigchld_set, NULL);
+            pid_t reaped;
+            while ((reaped = waitpid(-1, NULL, swapper_pending() ? WNOHANG : 0)) != -1)
+            {
+                if (reaped == 0)
+                {
+                    // Still running, and the scheduler may yet ask for a swapped-out process
+                    swapper_service(get_clk());
+                    usleep(10000);
+                }
+                else if (mm_check_pid_allocation(reaped, NULL, NULL))
+                    mm_free(reaped);
+            }
+            mm_flush_memory_log();
             // Clean up memory manager
             //mm_destroy();
             exit(0);
@@ -320,10 +773,10 @@ int main(int argc, char* argv[])
 }
 
 /*
- * Reads the input file and returns a ProcessMessage**, a pointer to an
- * array of ProcessMessage, of size MAX_INPUT_PROCESSES
+ * Reads the input file and returns a contiguous array of processParameters,
+ * sized to the number of process lines in the file
  */
-processParameters** read_process_file(const char* filename, int* count)
+processParameters* read_process_file(const char* filename, int* count)
 {
     FILE* file = fopen(filename, "r");
 
@@ -346,19 +799,15 @@ processParameters** read_process_file(const char* filename, int* count)
         }
     }
 
-    // Allocate memory for process message pointers
-    /// Assuming a maximum of MAX_INPUT_PROCESSES processes
-    processParameters** process_messages = (processParameters**)
-        malloc(MAX_INPUT_PROCESSES * sizeof(processParameters*));
-
-    // Initialize all pointers to NULL
-    for (int i = 0; i < MAX_INPUT_PROCESSES; i++)
+    // One record per process line, however many there are
+    processParameters* process_messages = (processParameters*)
+        malloc((line_count > 0 ? line_count : 1) * sizeof(processParameters));
+    if (!process_messages)
     {
-        process_messages[i] = NULL;
+        perror(ANSI_COLOR_MAGENTA"[MAIN] Failed to allocate process table"ANSI_COLOR_RESET);
+        exit(1);
     }
 
-    *count = line_count;
-
     // Reset file pointer to beginning
     rewind(file);
 
@@ -393,59 +842,65 @@ processParameters** read_process_file(const char* filename, int* count)
             }
         }
 
-        // Allocate memory for each ProcessMessage
-        process_messages[index] = (processParameters*)malloc(sizeof(processParameters));
-
         // Set values
-        process_messages[index]->mtype = 1; // Default message type
-        process_messages[index]->id = id;
-        process_messages[index]->arrival_time = arrival;
-        process_messages[index]->runtime = runtime;
-        process_messages[index]->priority = priority;
-        process_messages[index]->memsize = memsize;  // Store memory size
+        process_messages[index].mtype = 1; // Default message type
+        process_messages[index].id = id;
+        process_messages[index].pid = 0;
+        process_messages[index].arrival_time = arrival;
+        process_messages[index].runtime = runtime;
+        process_messages[index].priority = priority;
+        process_messages[index].memsize = memsize;  // Store memory size
 
         index++;
     }
 
     fclose(file);
 
+    // Lines that failed to parse are skipped, so only count what was read
+    *count = index;
+
     if (DEBUG)
         printf(ANSI_COLOR_BLUE"[PROC_GENERATOR] Read %d processes from file\n"ANSI_COLOR_RESET, index);
 
     return process_messages;
 }
 
+// Children that finish together are freed as one batch
+#define REAP_BATCH 64
+
 void child_process_handler(int signum)
 {
     signal(SIGCHLD, child_process_handler);
     int status;
     pid_t pid;
-    pid = waitpid(-1, &status, WNOHANG);
-    
-    if (pid <= 0) return; // No child or error, just return
-    
-    if (DEBUG)
-        printf(ANSI_COLOR_BLUE"[PROC_GENERATOR] Child process PID: %d has terminated with status %d\n"ANSI_COLOR_RESET,
-               pid, WEXITSTATUS(status));
-                
-    // Check if this PID has memory allocated before freeing
-    // This ensures we don't try to free memory that wasn't allocated
-    // or was already freed
-    int offset = -1;
-    size_t size = 0;
-    
-    if (mm_check_pid_allocation(pid, &offset, &size)) {
-        // Free memory when process terminates
-        mm_free(pid);
-        
-        if (DEBUG)
-            printf(ANSI_COLOR_BLUE"[PROC_GENERATOR] Released memory for terminated process PID: %d (offset: %d, size: %zu)\n"ANSI_COLOR_RESET,
-                pid, offset, size);
-    } else {
-        if (DEBUG)
-            printf(ANSI_COLOR_YELLOW"[PROC_GENERATOR] Process PID: %d had no memory allocated or was already freed\n"ANSI_COLOR_RESET,
-                pid);
-    }
+    int ids[REAP_BATCH];
+    int count;
+
+    // Signals merge while one is pending, so reap every child that has exited
+    do
+    {
+        count = 0;
+        while (count < REAP_BATCH && (pid = waitpid(-1, &status, WNOHANG)) > 0)
+        {
+            if (DEBUG)
+                printf(ANSI_COLOR_BLUE"[PROC_GENERATOR] Child process PID: %d has terminated with status %d\n"ANSI_COLOR_RESET,
+                       pid, WEXITSTATUS(status));
+
+            // Only processes that still hold memory are freed
+            if (mm_check_pid_allocation(pid, NULL, NULL))
+                ids[count++] = mm_get_id_by_pid(pid);
+            else if (DEBUG)
+                printf(ANSI_COLOR_YELLOW"[PROC_GENERATOR] Process PID: %d had no memory allocated or was already freed\n"ANSI_COLOR_RESET,
+                    pid);
+        }
+
+        if (count > 0)
+        {
+            mm_free_batch(ids, count);
+            if (DEBUG)
+                printf(ANSI_COLOR_BLUE"[PROC_GENERATOR] Released memory for %d terminated process(es)\n"ANSI_COLOR_RESET, count);
+        }
+    } while (count == REAP_BATCH);
 }
 
 void process_generator_cleanup(int scheduler_pid)
@@ -457,17 +912,22 @@ void process_generator_cleanup(int scheduler_pid)
     if (cleanup_in_progress) return;
     cleanup_in_progress = 1;
 
+    if (arrival_wheel != NULL)
+    {
+        destroy_timer_wheel(arrival_wheel);
+        arrival_wheel = NULL;
+    }
+    free(arrival_timers);
+    arrival_timers = NULL;
+    free(arrival_batch);
+    arrival_batch = NULL;
+    free(arrival_requests);
+    arrival_requests = NULL;
+    free(arrival_offsets);
+    arrival_offsets = NULL;
+
     if (process_parameters != NULL)
     {
-        // Free each ProcessMessage
-        for (int i = 0; i < 100; i++)
-        {
-            if (process_parameters[i] != NULL)
-            {
-                free(process_parameters[i]);
-                process_parameters[i] = NULL;
-            }
-        }
         free(process_parameters);
         process_parameters = NULL; // Ensure this is set to NULL
     }
@@ -8,26 +8,213 @@
 
 #include "clk.h"
 #include "scheduler_utils.h"
-#include "min_heap.h"
-#include "queue.h"
+#include "index_heap.h"
+#include "index_queue.h"
+#include "pcb_pool.h"
+#include "timer_wheel.h"
 #include <sys/types.h>
 #include <sys/wait.h>
 #include "shared_mem.h"
+#include "swapper.h"
+#include "paging.h"
 
 #include "headers.h"
 #include "colors.h"
 extern int total_busy_time;
-extern finishedProcessInfo** finished_process_info;
-// Use pointers for both possible queue types
-min_heap_t* min_heap_queue = NULL;
-Queue* rr_queue = NULL;
+// Ready queues hold pcb_pool slot indices; only one of them is used per run
+index_heap_t* min_heap_queue = NULL;
+index_queue_t* rr_queue = NULL;
 
 extern int msgid;
 extern int scheduler_type;
 extern int quantum;
-extern finishedProcessInfo** finished_process_info;
+extern float context_switch_cost;
+extern float cache_refill_penalty;
+extern int context_switches;
+extern int cache_refills;
+extern float switch_overhead;
+extern finishedProcessInfo* finished_process_info;
 extern int finished_processes_count;
+extern int finished_process_capacity;
+extern memory_stats_t* memory_stats;
+extern memorySample* memory_samples;
+extern int memory_sample_count;
+extern int memory_sample_capacity;
+extern long total_memory_wait;
+extern int max_memory_wait;
+extern int admitted_processes;
+extern int* memory_waits;
+extern int memory_wait_capacity;
+extern int swap_stall_ticks;
 int process_shm_id = -1; // Shared memory ID
+static pid_t last_dispatched_pid = -1;
+
+// Slice expirations (RR quanta, HPF bursts, SRTN units) are timer events
+static timer_wheel_t* slice_wheel = NULL;
+static tw_timer_t slice_timer;
+static int slice_expired = 0;
+
+static void on_slice_end(tw_timer_t* timer, void* arg)
+{
+    slice_expired = 1;
+}
+
+/*
+ * Let the dispatched process run `time_slice` ticks from `start_clk`.
+ * Until the slice timer fires the scheduler only receives arrivals; the
+ * shared-memory handshake is polled once the slice is due, to confirm the
+ * process has actually reported it done.
+ */
+static void wait_for_slice(pid_t pid, int start_clk, int time_slice)
+{
+    slice_expired = 0;
+    timer_wheel_add(slice_wheel, &slice_timer, start_clk + time_slice);
+    while (!slice_expired)
+    {
+        receive_processes();
+        timer_wheel_advance(slice_wheel, get_clk());
+    }
+
+    while (read_process_info(process_shm_id, pid).status)
+    {
+        receive_processes();
+    }
+}
+
+static float switch_debt = 0; // Charged overhead not yet spent as whole ticks
+
+// Make room for `needed` finished-process records. Called when a process is
+// admitted so that child_cleanup(), which runs as a signal handler, never
+// has to reallocate; the caller blocks SIGCHLD, as the handler writes into
+// the array being moved.
+static int reserve_finished_process_info(int needed)
+{
+    if (needed <= finished_process_capacity)
+        return 0;
+
+    int new_capacity = finished_process_capacity ? finished_process_capacity : INITIAL_PROCESS_CAPACITY;
+    while (new_capacity < needed)
+        new_capacity *= 2;
+
+    finishedProcessInfo* grown = realloc(finished_process_info, sizeof(finishedProcessInfo) * new_capacity);
+    if (!grown)
+    {
+        perror("Failed to grow finished_process_info");
+        return -1;
+    }
+    finished_process_info = grown;
+    finished_process_capacity = new_capacity;
+    return 0;
+}
+
+/*
+ * Charge the cost of dispatching the process in `slot` before it runs.
+ * Switching to a different process than the last one dispatched costs
+ * context_switch_cost; resuming one that was stopped also pays
+ * cache_refill_penalty. Overhead accumulates as fractional ticks and every
+ * whole tick of it is spent with the CPU doing no useful work, new arrivals
+ * still being received meanwhile.
+ */
+static void charge_dispatch(uint32_t slot)
+{
+    if (slot == PCB_SLOT_NONE)
+        return;
+
+    pid_t pid = pcb_pool->cold[slot].pid;
+    if (pid == last_dispatched_pid)
+        return;
+    last_dispatched_pid = pid;
+
+    float cost = context_switch_cost;
+    context_switches++;
+    if (pcb_pool->cold[slot].start_time != -1)
+    {
+        cost += cache_refill_penalty;
+        cache_refills++;
+    }
+    if (cost <= 0)
+        return;
+
+    switch_overhead += cost;
+    switch_debt += cost;
+    while (switch_debt >= 1)
+    {
+        int tick = get_clk();
+        while (get_clk() == tick)
+            receive_processes();
+        switch_debt -= 1;
+    }
+}
+
+/*
+ * Make sure the process in `slot` is in memory before it is dispatched. If the
+ * swapper evicted it, ask for it back and stall until the transfer completes,
+ * receiving arrivals meanwhile; the stall is CPU time lost to swapping.
+ */
+static void swap_in_for_dispatch(uint32_t slot)
+{
+    if (slot == PCB_SLOT_NONE || !swapper_enabled())
+        return;
+
+    int id = pcb_pool->cold[slot].id;
+    if (swapper_claim(id))
+        return;
+
+    int stall_start = get_clk();
+    if (DEBUG)
+        printf(ANSI_COLOR_GREEN"[SCHEDULER] Process %d is swapped out, waiting for it to be swapped in\n"
+               ANSI_COLOR_RESET, id);
+    while (!swapper_arrived(id, get_clk()))
+        receive_processes();
+    swap_stall_ticks += get_clk() - stall_start;
+}
+
+/*
+ * Take the next process off the ready queue, charge the switch to it and swap it
+ * back in if it was evicted. Arrivals received while the overhead or the swap is
+ * spent queue up behind it: the process taken out is the one that runs, so the
+ * process charged and claimed is always the one dispatched.
+ */
+static uint32_t take_next_process(void)
+{
+    uint32_t slot = PCB_SLOT_NONE;
+    if (scheduler_type == RR)
+    {
+        if (!index_queue_is_empty(rr_queue))
+            slot = index_queue_pop(rr_queue);
+    }
+    else if (!index_heap_is_empty(min_heap_queue))
+        slot = index_heap_extract_min(min_heap_queue);
+
+    charge_dispatch(slot);
+    swap_in_for_dispatch(slot);
+    return slot;
+}
+
+static float fault_debt = 0; // Fault service time not yet spent as whole ticks
+
+/*
+ * Replay the page references of the `ticks` ticks process `id` just ran, and free
+ * its frames if it finished. The faults are serviced before the next dispatch:
+ * every whole tick of fault time is spent with the CPU doing no useful work,
+ * receiving arrivals meanwhile, as with switch overhead.
+ */
+static void run_paging(int id, int ticks, bool finished)
+{
+    if (!paging_enabled())
+        return;
+
+    fault_debt += paging_run(id, ticks);
+    if (finished)
+        paging_release(id);
+    while (fault_debt >= 1)
+    {
+        int tick = get_clk();
+        while (get_clk() == tick)
+            receive_processes();
+        fault_debt -= 1;
+    }
+}
 
 void run_scheduler()
 {
@@ -58,77 +245,78 @@ void run_scheduler()
 
         if (scheduler_type == HPF) // HPF
         {
+            uint32_t next = take_next_process();
+            if (next == PCB_SLOT_NONE) continue; // there is no process to run
             start_process_time = get_clk();
             int crt_clk = get_clk();
-            running_process = hpf(min_heap_queue, crt_clk);
-            if (running_process == NULL) continue; // there is no process to run
-            start_process_time = get_clk();
-            int time_slice = running_process->remaining_time;
+            running_process = hpf(next, crt_clk);
+            uint32_t slot = running_process;
+            int time_slice = pcb_pool->remaining_time[slot];
+            pid_t p_pid = pcb_pool->cold[slot].pid;
+            int id = pcb_pool->cold[slot].id;
 
             // Write current clock as handshake
-            write_process_info(process_shm_id, running_process->pid, time_slice, 1, crt_clk);
+            write_process_info(process_shm_id, p_pid, time_slice, 1, crt_clk);
 
-            running_process->remaining_time = 0;
-            pid_t p_pid = running_process->pid;
-            process_info_t process_info;
+            pcb_pool->remaining_time[slot] = 0;
 
             if (DEBUG)
                 printf(ANSI_COLOR_GREEN"[SCHEDULER] RUNNING PID %d for %d units\n"ANSI_COLOR_RESET,
-                       running_process->pid, time_slice);
-            kill(running_process->pid, SIGCONT);
+                       p_pid, time_slice);
+            kill(p_pid, SIGCONT);
 
-            while ((process_info = read_process_info(process_shm_id, p_pid)).status)
-            {
-                receive_processes();
-            }
+            wait_for_slice(p_pid, crt_clk, time_slice);
 
             // Wait until the process is cleanedup
-            while (running_process != NULL)
+            while (running_process != PCB_SLOT_NONE)
             {
                 receive_processes();
             }
             end_process_time = get_clk();
             total_busy_time += (end_process_time - start_process_time);
+            run_paging(id, time_slice, true);
         }
 
         else if (scheduler_type == SRTN)
         {
+            uint32_t next = take_next_process();
+            if (next == PCB_SLOT_NONE) continue; // there is no process to run
             start_process_time = get_clk();
-            running_process = srtn(min_heap_queue);
-            if (running_process == NULL) continue; // there is no process to run
+            running_process = srtn(next, get_clk());
 
-            pid_t p_pid = running_process->pid;
-            int remaining_time = running_process->remaining_time;
+            uint32_t slot = running_process;
+            pid_t p_pid = pcb_pool->cold[slot].pid;
+            int id = pcb_pool->cold[slot].id;
+            int remaining_time = pcb_pool->remaining_time[slot];
             int ran = 0;
             int preempt = 0;
             int crt_clk = get_clk();
+            int unit_clk = crt_clk;
 
             write_process_info(process_shm_id, p_pid, 1, 1, crt_clk);
             if (DEBUG)
                 printf(ANSI_COLOR_GREEN"[SCHEDULER] RUNNING PID %d for SRTN scheduling\n"ANSI_COLOR_RESET,
-                       running_process->pid);
-            kill(running_process->pid, SIGCONT);
+                       p_pid);
+            kill(p_pid, SIGCONT);
 
             // While the process has more time to run
             while (ran < remaining_time)
             {
-                // Wait until the process finishes the time slice and during that check if any new process arrives
-                while (read_process_info(process_shm_id, p_pid).status != 0)
-                {
-                    // Check if there are any newly arrived processes
-                    // If we received new processes and the min heap is not empty, check for preemption
-                    if (receive_processes() == 0 && !min_heap_is_empty(min_heap_queue))
-                    {
-                        PCB* shortest = (PCB*)min_heap_get_min(min_heap_queue);
-                        if (shortest && shortest->remaining_time < remaining_time - ran)
-                            // Preempt the current process
-                            preempt = 1;
-                    }
-                }
+                // Wait for the unit-end timer while receiving new arrivals
+                wait_for_slice(p_pid, unit_clk, 1);
 
                 ran++;
 
-                if (running_process)
+                // Preemption is checked at each unit boundary: does anything ready beat what is left?
+                if (!index_heap_is_empty(min_heap_queue))
+                {
+                    uint32_t shortest = index_heap_get_min(min_heap_queue);
+                    if (pcb_pool->remaining_time[shortest] < remaining_time - ran)
+                        // Preempt the current process
+                        preempt = 1;
+                }
+
+                if (running_process != PCB_SLOT_NONE)
                 {
                     // Process has more time to run
                     if (ran < remaining_time)
@@ -138,19 +326,20 @@ void run_scheduler()
 
                         // else
                         // Instruct process to run for another time unit
-                        write_process_info(process_shm_id, running_process->pid, 1, 1, get_clk());
+                        unit_clk = get_clk();
+                        write_process_info(process_shm_id, p_pid, 1, 1, unit_clk);
                         if (DEBUG)
                             printf(
                                 ANSI_COLOR_GREEN"[SCHEDULER] PID %d continued for another unit. %d/%d completed\n"
                                 ANSI_COLOR_RESET,
-                                running_process->pid, ran, running_process->remaining_time);
+                                p_pid, ran, remaining_time);
                     }
                     else
                     {
                         // Process completed its current time slice
                         if (DEBUG)
                             printf(ANSI_COLOR_GREEN"[SCHEDULER] PID %d completed time slice\n"ANSI_COLOR_RESET,
-                                   running_process->pid);
+                                   p_pid);
                         break;
                     }
                 }
@@ -160,7 +349,7 @@ void run_scheduler()
             if ((remaining_time - ran) <= 0)
             {
                 // Wait for the process to be cleaned up
-                while (running_process != NULL)
+                while (running_process != PCB_SLOT_NONE)
                 {
                     receive_processes();
                 }
@@ -168,24 +357,24 @@ void run_scheduler()
             }
 
             // handle preempting and process still exists and there is still time left
-            if (running_process && preempt)
+            if (running_process != PCB_SLOT_NONE && preempt)
             {
                 if ((remaining_time - ran) > 0)
                 {
                     // Update remaining time and reinsert into min heap
-                    running_process->remaining_time -= ran;
-                    running_process->last_run_time = get_clk();
-                    running_process->status = READY;
+                    pcb_pool->remaining_time[slot] -= ran;
+                    pcb_pool->cold[slot].last_run_time = get_clk();
+                    pcb_pool->status[slot] = READY;
 
-                    log_process_state(running_process, "stopped", get_clk()); // Add explicit preemption log
+                    log_process_state(slot, "stopped", get_clk()); // Add explicit preemption log
 
                     // Update process status to paused
-                    write_process_info(process_shm_id, running_process->pid, 0, 0, crt_clk);
-                    kill(running_process->pid, SIGTSTP); // Stop the process
+                    write_process_info(process_shm_id, p_pid, 0, 0, crt_clk);
+                    kill(p_pid, SIGTSTP); // Stop the process
 
                     int crt_time = get_clk();
                     // Wait gracefully until the process reports that it stopped
-                    while (get_clk() - crt_time < 10 && read_process_info(process_shm_id, running_process->pid).status)
+                    while (get_clk() - crt_time < 10 && read_process_info(process_shm_id, p_pid).status)
                     {
                         receive_processes();
                     }
@@ -194,58 +383,61 @@ void run_scheduler()
                             ANSI_COLOR_GREEN
                             "[SCHEDULER] PID %d preempted and reinserted into queue with %d units remaining\n"
                             ANSI_COLOR_RESET,
-                            p_pid, running_process->remaining_time);
+                            p_pid, remaining_time - ran);
 
-                    // Reinsert the process into the min heap
-                    min_heap_insert(min_heap_queue, running_process);
-                    running_process = NULL;
+                    // Reinsert the process into the min heap; it may be swapped out while it waits
+                    swapper_release(pcb_pool->cold[slot].id, get_clk());
+                    index_heap_insert(min_heap_queue, slot);
+                    running_process = PCB_SLOT_NONE;
                 }
             }
             end_process_time = get_clk();
             total_busy_time += (end_process_time - start_process_time);
+            run_paging(id, ran, remaining_time - ran <= 0);
         }
         else if (scheduler_type == RR)
         {
+            uint32_t next = take_next_process();
+            if (next == PCB_SLOT_NONE) continue; // there is no process to run
             start_process_time = get_clk();
             int crt_clk = get_clk();
-            running_process = rr(rr_queue, crt_clk);
-            if (running_process == NULL) continue; // there is no process to run
+            running_process = rr(next, crt_clk);
 
-            int remaining_time = running_process->remaining_time;
+            uint32_t slot = running_process;
+            int remaining_time = pcb_pool->remaining_time[slot];
             int time_slice = (remaining_time < quantum) ? remaining_time : quantum;
-            pid_t p_pid = running_process->pid;
+            bool last_slice = time_slice == remaining_time;
+            pid_t p_pid = pcb_pool->cold[slot].pid;
+            int id = pcb_pool->cold[slot].id;
 
             // Write current clock as handshake
-            write_process_info(process_shm_id, running_process->pid, time_slice, 1, crt_clk);
+            write_process_info(process_shm_id, p_pid, time_slice, 1, crt_clk);
 
             if (DEBUG)
                 printf(ANSI_COLOR_GREEN"[SCHEDULER] Running PID %d for %d units (RR)\n"ANSI_COLOR_RESET,
-                       running_process->pid, time_slice);
+                       p_pid, time_slice);
 
             // Continue the process
-            kill(running_process->pid, SIGCONT);
+            kill(p_pid, SIGCONT);
 
-            // Wait for the process to finish its time slice
-            while (read_process_info(process_shm_id, p_pid).status)
-            {
-                receive_processes(); // Check for new arrivals while waiting
-            }
+            // Wait for the process to finish its time slice, checking for new arrivals meanwhile
+            wait_for_slice(p_pid, crt_clk, time_slice);
 
-            if (running_process != NULL)
+            if (running_process != PCB_SLOT_NONE)
             {
                 // Update process accounting
                 remaining_time -= time_slice;
-                running_process->last_run_time = get_clk();
+                pcb_pool->cold[slot].last_run_time = get_clk();
 
                 if (DEBUG)
                     printf(
                         ANSI_COLOR_GREEN"[SCHEDULER] PID %d finished time slice. Remaining time: %d\n"ANSI_COLOR_RESET,
-                        running_process->pid, remaining_time);
+                        p_pid, remaining_time);
 
                 if (remaining_time <= 0)
                 {
                     // Wait for the process to be cleaned up
-                    while (running_process != NULL)
+                    while (running_process != PCB_SLOT_NONE)
                     {
                         receive_processes();
                     }
@@ -255,14 +447,15 @@ void run_scheduler()
                 else
                 {
                     // Process still has time remaining, put it back in the queue
-                    running_process->status = READY;
-                    running_process->remaining_time = remaining_time;
+                    pcb_pool->status[slot] = READY;
+                    pcb_pool->remaining_time[slot] = remaining_time;
 
-                    log_process_state(running_process, "stopped", get_clk());
+                    log_process_state(slot, "stopped", get_clk());
                     kill(p_pid, SIGTSTP);
 
-                    enqueue(rr_queue, running_process);
-                    running_process = NULL;
+                    swapper_release(pcb_pool->cold[slot].id, get_clk());
+                    index_queue_push(rr_queue, slot);
+                    running_process = PCB_SLOT_NONE;
 
                     if (DEBUG)
                         printf(
@@ -276,6 +469,7 @@ void run_scheduler()
             }
             end_process_time = get_clk();
             total_busy_time += (end_process_time - start_process_time);
+            run_paging(id, time_slice, last_slice);
         }
     }
 
@@ -287,6 +481,9 @@ void run_scheduler()
 
 int receive_processes(void)
 {
+    // Every wait loop polls here, so this is where memory is sampled once per tick
+    sample_memory_stats(get_clk());
+
     if (msgid == -1)
         return -1;
 
@@ -311,6 +508,13 @@ int receive_processes(void)
         }
     }
 
+    // child_cleanup() frees pool slots and records finished processes from the SIGCHLD
+    // handler, so it is held off while a slot is taken and while either table may be
+    // reallocated under it
+    sigset_t sigchld_set, old_set;
+    sigemptyset(&sigchld_set);
+    sigaddset(&sigchld_set, SIGCHLD);
+
     while (recv_val != -1)
     {
         printf(
@@ -318,18 +522,43 @@ int receive_processes(void)
             ANSI_COLOR_RESET,
             received_pcb.pid, received_pcb.arrival_time, received_pcb.remaining_time, get_clk());
 
-        PCB* new_pcb = (PCB*)malloc(sizeof(PCB));
-        if (!new_pcb)
-        {
-            perror("Failed to allocate memory for PCB");
+        sigprocmask(SIG_BLOCK, &sigchld_set, &old_set);
+        uint32_t slot = PCB_SLOT_NONE;
+        if (reserve_finished_process_info(finished_processes_count + process_count + 1) == 0)
+            slot = pcb_pool_alloc(pcb_pool);
+        if (slot != PCB_SLOT_NONE)
+            pcb_pool_store(pcb_pool, slot, &received_pcb);
+        sigprocmask(SIG_SETMASK, &old_set, NULL);
+        if (slot == PCB_SLOT_NONE)
             break;
+
+        // Admission latency: how long the process waited for memory before it was sent
+        int memory_wait = get_clk() - received_pcb.arrival_time;
+        if (memory_wait < 0)
+            memory_wait = 0;
+        total_memory_wait += memory_wait;
+        if (memory_wait > max_memory_wait)
+            max_memory_wait = memory_wait;
+        if (admitted_processes == memory_wait_capacity)
+        {
+            int new_capacity = memory_wait_capacity ? memory_wait_capacity * 2 : INITIAL_PROCESS_CAPACITY;
+            int* grown = realloc(memory_waits, sizeof(int) * new_capacity);
+            if (grown)
+            {
+                memory_waits = grown;
+                memory_wait_capacity = new_capacity;
+            }
+            else
+                perror("Failed to grow memory_waits");
         }
-        *new_pcb = received_pcb; // shallow copy, doesnt matter
+        if (admitted_processes < memory_wait_capacity)
+            memory_waits[admitted_processes] = memory_wait;
+        admitted_processes++;
 
         if (scheduler_type == HPF || scheduler_type == SRTN)
-            min_heap_insert(min_heap_queue, new_pcb);
+            index_heap_insert(min_heap_queue, slot);
         else if (scheduler_type == RR)
-            enqueue(rr_queue, new_pcb);
+            index_queue_push(rr_queue, slot);
 
         process_count++;  // Changed from process_count to process_count
         recv_val = msgrcv(msgid, &received_pcb, sizeof(PCB), 1, IPC_NOWAIT);
@@ -360,33 +589,36 @@ void scheduler_cleanup(int signum)
     cleanup_shared_memory(process_shm_id);
     process_shm_id = -1;
 
-    // Cleanup memory resources if they still exist
+    detach_memory_stats(memory_stats);
+    memory_stats = NULL;
+    cleanup_memory_stats(MEMORY_STATS_SHM_KEY);
+    swapper_destroy();
+
+    // Cleanup memory resources if they still exist; queued PCBs live in the pool
     if (min_heap_queue)
     {
-        // Free any remaining PCBs in the heap
-        while (min_heap_queue->size > 0)
-        {
-            PCB* pcb = min_heap_extract_min(min_heap_queue);
-            if (pcb)
-                free(pcb);
-        }
-        free(min_heap_queue);
+        destroy_index_heap(min_heap_queue);
         min_heap_queue = NULL;
     }
 
     if (rr_queue)
     {
-        // Free any remaining PCBs in the queue
-        while (!isQueueEmpty(rr_queue))
-        {
-            PCB* pcb = dequeue(rr_queue);
-            if (pcb)
-                free(pcb);
-        }
-        free(rr_queue);
+        destroy_index_queue(rr_queue);
         rr_queue = NULL;
     }
 
+    if (pcb_pool)
+    {
+        pcb_pool_destroy(pcb_pool);
+        pcb_pool = NULL;
+    }
+
+    if (slice_wheel)
+    {
+        destroy_timer_wheel(slice_wheel);
+        slice_wheel = NULL;
+    }
+
     // Don't try to remove the message queue that's already been removed
     if (msgid != -1)
     {
@@ -399,19 +631,17 @@ void scheduler_cleanup(int signum)
         msgid = -1;
     }
 
-    for (int i = 0; i < MAX_INPUT_PROCESSES; i++)
-        if (finished_process_info[i] != NULL)
-        {
-            free(finished_process_info[i]);
-            finished_process_info[i] = NULL;
-        }
-
     if (finished_process_info != NULL)
     {
         free(finished_process_info);
         finished_process_info = NULL;
+        finished_process_capacity = 0;
     }
 
+    free(memory_samples);
+    memory_samples = NULL;
+    memory_sample_count = memory_sample_capacity = 0;
+
     if (DEBUG)
         printf(ANSI_COLOR_GREEN"[SCHEDULER] scheduler_cleanup FINISHED \n"ANSI_COLOR_RESET);
 
@@ -423,52 +653,39 @@ void scheduler_cleanup(int signum)
 
 void child_cleanup()
 {
-    if (running_process == NULL) return;;
+    if (running_process == PCB_SLOT_NONE) return;
 
     // sync_clk();
     signal(SIGCHLD, child_cleanup);
     if (DEBUG)
         printf(ANSI_COLOR_GREEN"[SCHEDULER] CHILD_CLEANUP CALLED\n"ANSI_COLOR_RESET);
 
-    if (running_process)
+    if (running_process != PCB_SLOT_NONE)
     {
         int current_time = get_clk();
-        running_process->finish_time = current_time;
-        running_process->remaining_time = 0;
-        log_process_state(running_process, "finished", current_time);
-        if (finished_processes_count < MAX_INPUT_PROCESSES)
+        uint32_t slot = running_process;
+        pcb_cold_t* process = &pcb_pool->cold[slot];
+        process->finish_time = current_time;
+        pcb_pool->remaining_time[slot] = 0;
+        log_process_state(slot, "finished", current_time);
+        // Capacity was reserved when the process was received
+        if (finished_processes_count < finished_process_capacity)
         {
-            if (finished_process_info[finished_processes_count] == NULL)
-            {
-                finished_process_info[finished_processes_count] = (finishedProcessInfo*)malloc(
-                    sizeof(finishedProcessInfo));
-                if (!finished_process_info[finished_processes_count])
-                {
-                    perror("Failed to malloc finished_process_info");
-                }
-                else
-                {
-                    // Only access if malloc succeeded
-                    finished_process_info[finished_processes_count]->ta = current_time - running_process
-                        ->arrival_time;
-                    finished_process_info[finished_processes_count]->wta =
-                        (running_process->runtime > 0)
-                            ? ((float)(finished_process_info[finished_processes_count]->ta) / running_process->runtime)
-                            : 0.0;
-                    finished_process_info[finished_processes_count]->waiting_time = running_process->waiting_time;
-                }
-            }
-
-            process_count--;  // Changed from process_count to process_count
+            finishedProcessInfo* info = &finished_process_info[finished_processes_count];
+            info->ta = current_time - pcb_pool->arrival_time[slot];
+            info->wta = (process->runtime > 0) ? ((float)info->ta / process->runtime) : 0.0;
+            info->waiting_time = process->waiting_time;
             finished_processes_count++;
         }
         else
         {
-            printf(ANSI_COLOR_GREEN"[SCHEDULER] WARNING: Exceeded maximum number of processes!\n"ANSI_COLOR_RESET);
+            printf(ANSI_COLOR_GREEN"[SCHEDULER] WARNING: No record reserved for finished process %d\n"ANSI_COLOR_RESET,
+                   process->id);
         }
+        process_count--;  // Changed from process_count to process_count
 
-        free(running_process);
-        running_process = NULL;
+        pcb_pool_free(pcb_pool, running_process);
+        running_process = PCB_SLOT_NONE;
     }
     else
     {
@@ -482,7 +699,14 @@ int init_scheduler()
 {
     int current_time = get_clk();
     process_count = 0;  // Changed from process_count to process_count
-    running_process = NULL;
+    running_process = PCB_SLOT_NONE;
+
+    pcb_pool = pcb_pool_create(INITIAL_PROCESS_CAPACITY);
+    if (pcb_pool == NULL)
+    {
+        perror("Failed to create pcb_pool");
+        return -1;
+    }
 
     // Initialize shared memory
     process_shm_id = create_shared_memory(SHM_KEY);
@@ -494,7 +718,7 @@ int init_scheduler()
 
     if (scheduler_type == HPF || scheduler_type == SRTN)
     {
-        min_heap_queue = create_min_heap(MAX_INPUT_PROCESSES, compare_processes);
+        min_heap_queue = create_index_heap(INITIAL_PROCESS_CAPACITY, compare_processes);
         if (min_heap_queue == NULL)
         {
             perror("Failed to create min_heap_queue");
@@ -503,15 +727,25 @@ int init_scheduler()
     }
     else if (scheduler_type == RR)
     {
-        rr_queue = (Queue*)malloc(sizeof(Queue));
+        rr_queue = create_index_queue(INITIAL_PROCESS_CAPACITY);
         if (rr_queue == NULL)
         {
             perror("Failed to allocate memory for rr_queue");
             return -1;
         }
-        initQueue(rr_queue, sizeof(PCB));
     }
 
+    // Counters the memory manager publishes; the run goes on without them if unavailable
+    memory_stats = attach_memory_stats(MEMORY_STATS_SHM_KEY);
+
+    slice_wheel = create_timer_wheel(current_time);
+    if (slice_wheel == NULL)
+    {
+        perror("Failed to create slice_wheel");
+        return -1;
+    }
+    tw_timer_init(&slice_timer, on_slice_end, NULL);
+
     // Init IPC
     key_t key = ftok("process_generator", 65);
     msgid = msgget(key, 0666 | IPC_CREAT);
@@ -530,17 +764,8 @@ int init_scheduler()
     fprintf(log_file, "#At\ttime\tx\tprocess\ty\tstate\tarr\tw\ttotal\tz\tremain\ty\twait\tk\n");
 
     finished_processes_count = 0;
-    finished_process_info = (finishedProcessInfo**)malloc(MAX_INPUT_PROCESSES * sizeof(finishedProcessInfo*));
-
-    if (!finished_process_info)
-    {
-        perror("Failed to allocate memory for PCB");
+    if (reserve_finished_process_info(INITIAL_PROCESS_CAPACITY) == -1)
         return -1;
-    }
-
-    // Initialize all pointers to NULL
-    for (int i = 0; i < MAX_INPUT_PROCESSES; i++)
-        finished_process_info[i] = NULL;
 
     if (DEBUG)
         printf(ANSI_COLOR_GREEN"[SCHEDULER] Scheduler initialized successfully at time %d\n"ANSI_COLOR_RESET,
@@ -1,15 +1,16 @@
 #pragma once
 
 #include <stdio.h>
+#include <stdint.h>
 #include "pcb.h"
-#include "min_heap.h"
+#include "pcb_pool.h"
 
 void scheduler_cleanup(int signum);
 void run_scheduler();
 int init_scheduler();
 void generate_statistics();
-int compare_processes(const void* a, const void* b);
-void log_process_state(PCB* process, char* state, int time);
+int compare_processes(uint32_t a, uint32_t b);
+void log_process_state(uint32_t slot, char* state, int time);
 int receive_processes(void);
 void child_cleanup();
 
@@ -17,7 +18,7 @@ void child_cleanup();
 extern int current_time;
 extern int process_count;  
 extern int completed_process_count;
-extern PCB* running_process;
-extern min_heap_t* ready_queue;
+extern uint32_t running_process; // Slot in pcb_pool, PCB_SLOT_NONE when idle
+extern pcb_pool_t* pcb_pool;
 extern int msg_queue_id;
 extern FILE* log_file;
@@ -3,13 +3,29 @@
 #include "headers.h"
 #include "min_heap.h"
 #include "pcb.h"
+#include "pcb_pool.h"
+#include "shared_mem.h"
 
 // Global variables
 int process_count = 0;
-PCB* running_process = NULL;
-min_heap_t* ready_queue = NULL;
+uint32_t running_process = PCB_SLOT_NONE;
+pcb_pool_t* pcb_pool = NULL;
 FILE* log_file = NULL;
-finishedProcessInfo** finished_process_info;
+finishedProcessInfo* finished_process_info = NULL; // Contiguous, grows with admissions
 int finished_processes_count;
+int finished_process_capacity = 0;
 int cpu_idle_time = 0;
-int total_busy_time = 0;
\ No newline at end of file
+int total_busy_time = 0;
+int context_switches = 0;
+int cache_refills = 0;
+float switch_overhead = 0; // Ticks charged for switches and refills
+memory_stats_t* memory_stats = NULL; // Live counters published by the memory manager
+memorySample* memory_samples = NULL; // One sample per tick, grows as the run goes on
+int memory_sample_count = 0;
+int memory_sample_capacity = 0;
+long total_memory_wait = 0; // Ticks between arrival and admission, over received processes
+int max_memory_wait = 0;
+int admitted_processes = 0;
+int* memory_waits = NULL; // Each admitted process's memory wait, for percentiles
+int memory_wait_capacity = 0;
+int swap_stall_ticks = 0; // Ticks the CPU waited for dispatched processes to be swapped in
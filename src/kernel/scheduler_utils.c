@@ -5,126 +5,147 @@
 #include <bits/signum-arch.h>
 #include "clk.h"
 #include "pcb.h"
-#include "queue.h"
+#include "pcb_pool.h"
 #include "scheduler.h"
 #include "headers.h"
-#include "min_heap.h"
+#include "scheduler_utils.h"
 #include "process_generator.h"
 #include "colors.h"
 #include "shared_mem.h"
+#include "allocator.h"
+#include "swapper.h"
+#include "paging.h"
+#include "memory_manager.h"
 extern int total_busy_time;
 extern int scheduler_type;
-extern finishedProcessInfo** finished_process_info;
+extern finishedProcessInfo* finished_process_info;
 extern int finished_processes_count;
+extern int context_switches;
+extern int cache_refills;
+extern float switch_overhead;
+extern memory_stats_t* memory_stats;
+extern memorySample* memory_samples;
+extern int memory_sample_count;
+extern int memory_sample_capacity;
+extern long total_memory_wait;
+extern int max_memory_wait;
+extern int admitted_processes;
+extern int* memory_waits;
+extern int memory_wait_capacity;
+extern admission_policy_t admission_policy;
+extern alloc_policy_t memory_policy;
+extern arena_spec_t arena_specs[];
+extern int arena_count;
+extern placement_policy_t placement_policy;
+extern int paging_policy;
+extern int swap_stall_ticks;
 
-// compare function for priority queue
-int compare_processes(const void* p1, const void* p2)
+// compare function for priority queue; reads only the hot key columns
+int compare_processes(uint32_t slot1, uint32_t slot2)
 {
-    PCB* process1 = (PCB*)p1;
-    PCB* process2 = (PCB*)p2;
     if (scheduler_type == HPF)
     {
-        if (process1->priority != process2->priority)
+        if (pcb_pool->priority[slot1] != pcb_pool->priority[slot2])
         {
-            return process1->priority - process2->priority;
+            return pcb_pool->priority[slot1] - pcb_pool->priority[slot2];
         }
 
         // If priorities are equal return that come first
-        return process1->arrival_time - process2->arrival_time;
+        return pcb_pool->arrival_time[slot1] - pcb_pool->arrival_time[slot2];
     }
     else // SRTN
     {
-        if (process1->remaining_time != process2->remaining_time)
+        if (pcb_pool->remaining_time[slot1] != pcb_pool->remaining_time[slot2])
         {
-            return process1->remaining_time - process2->remaining_time;
+            return pcb_pool->remaining_time[slot1] - pcb_pool->remaining_time[slot2];
         }
 
         // If priorities are equal return that come first
-        return process1->arrival_time - process2->arrival_time;
+        return pcb_pool->arrival_time[slot1] - pcb_pool->arrival_time[slot2];
     }
 }
 
-// HPF algorithm
-PCB* hpf(min_heap_t* ready_queue, int current_time)
+// HPF algorithm: start the process taken off the ready queue
+uint32_t hpf(uint32_t slot, int current_time)
 {
-    if (!min_heap_is_empty(ready_queue))
+    if (slot == PCB_SLOT_NONE)
+        return PCB_SLOT_NONE;
+
+    pcb_cold_t* next_process = &pcb_pool->cold[slot];
+    pcb_pool->status[slot] = RUNNING;
+    next_process->waiting_time = current_time - pcb_pool->arrival_time[slot];
+    // assuming that any process is initially having start time -1
+    if (next_process->start_time == -1)
     {
-        PCB* next_process = min_heap_extract_min(ready_queue);
-        next_process->status = RUNNING;
-        next_process->waiting_time = current_time - next_process->arrival_time;
-        // assuming that any process is initially having start time -1
-        if (next_process->start_time == -1)
-        {
-            next_process->start_time = current_time;
-        }
-        log_process_state(next_process, "started", current_time);
-        kill(next_process->pid,SIGCONT);
-        return next_process;
+        next_process->start_time = current_time;
     }
-    return NULL;
+    log_process_state(slot, "started", current_time);
+    kill(next_process->pid,SIGCONT);
+    return slot;
 }
 
-PCB* srtn(min_heap_t* ready_queue)
+uint32_t srtn(uint32_t slot, int current_time)
 {
-    int current_time = get_clk();
-    if (!min_heap_is_empty(ready_queue))
+    if (slot == PCB_SLOT_NONE)
+        return PCB_SLOT_NONE;
+
+    pcb_cold_t* next_process = &pcb_pool->cold[slot];
+    pcb_pool->status[slot] = RUNNING;
+    if (next_process->last_run_time == -1)
     {
-        PCB* next_process = min_heap_extract_min(ready_queue);
-        next_process->status = RUNNING;
-        if (next_process->last_run_time == -1)
-        {
-            next_process->waiting_time = current_time - next_process->arrival_time;
-        }
-        else next_process->waiting_time += current_time - next_process->last_run_time;
+        next_process->waiting_time = current_time - pcb_pool->arrival_time[slot];
+    }
+    else next_process->waiting_time += current_time - next_process->last_run_time;
 
-        // assuming that any process is initially having start time -1
-        if (next_process->start_time == -1)
-        {
-            log_process_state(next_process, "started", current_time);
-            next_process->start_time = current_time;
-            next_process->response_time = next_process->start_time - next_process->arrival_time;
-        }
-        else
-            log_process_state(next_process, "resumed", current_time);
-        return next_process;
+    // assuming that any process is initially having start time -1
+    if (next_process->start_time == -1)
+    {
+        log_process_state(slot, "started", current_time);
+        next_process->start_time = current_time;
+        next_process->response_time = next_process->start_time - pcb_pool->arrival_time[slot];
     }
-    return NULL;
+    else
+        log_process_state(slot, "resumed", current_time);
+    return slot;
 }
 
 
-// RR algorithm
-PCB* rr(Queue* ready_queue, int current_time)
+// RR algorithm: start the process taken off the ready queue
+uint32_t rr(uint32_t slot, int current_time)
 {
-    if (!isQueueEmpty(ready_queue))
-    {
-        PCB* next_process = dequeue(ready_queue);
-        next_process->status = RUNNING;
-        next_process->waiting_time = (current_time - next_process->arrival_time) - (next_process->runtime - next_process
-            ->remaining_time);
-        if (next_process->start_time == -1)
-        {
-            next_process->start_time = current_time;
-            next_process->response_time = current_time - next_process->arrival_time;
-            log_process_state(next_process, "started", current_time);
-        }
-        else
-        {
-            log_process_state(next_process, "resumed", current_time);
-        }
+    if (slot == PCB_SLOT_NONE)
+        return PCB_SLOT_NONE;
 
-        return next_process;
+    pcb_cold_t* next_process = &pcb_pool->cold[slot];
+    pcb_pool->status[slot] = RUNNING;
+    next_process->waiting_time = (current_time - pcb_pool->arrival_time[slot]) - (next_process->runtime -
+        pcb_pool->remaining_time[slot]);
+    if (next_process->start_time == -1)
+    {
+        next_process->start_time = current_time;
+        next_process->response_time = current_time - pcb_pool->arrival_time[slot];
+        log_process_state(slot, "started", current_time);
+    }
+    else
+    {
+        log_process_state(slot, "resumed", current_time);
     }
-    return NULL;
+
+    return slot;
 }
 
 // Update log_process_state to handle more states
-void log_process_state(PCB* process, char* state, int time)
+void log_process_state(uint32_t slot, char* state, int time)
 {
+    const pcb_cold_t* process = &pcb_pool->cold[slot];
+    int arrival_time = pcb_pool->arrival_time[slot];
+    int remaining_time = pcb_pool->remaining_time[slot];
+
     if (strcmp(state, "started") == 0)
     {
         fprintf(log_file, "At time %d process %d %s arr %d total %d remain %d wait %d\n",
-            time, process->id, state, process->arrival_time, process->runtime,
-            process->remaining_time, process->waiting_time);
+            time, process->id, state, arrival_time, process->runtime,
+            remaining_time, process->waiting_time);
 
         if(DEBUG)
         printf(ANSI_COLOR_GREEN"[SCHEDULER] Process %d started at time %d\n"ANSI_COLOR_RESET,
@@ -133,10 +154,10 @@ void log_process_state(PCB* process, char* state, int time)
     else if (strcmp(state, "finished") == 0)
     {
         fprintf(log_file, "At time %d process %d %s arr %d total %d remain %d wait %d TA %d WTA %.2f\n",
-                time, process->id, state, process->arrival_time, process->runtime,
-                process->remaining_time, process->waiting_time,
-                (time - process->arrival_time), // Turnaround time
-                (process->runtime > 0) ? ((float)(time - process->arrival_time) / process->runtime) : 0.0); /* Weighted turnaround time */
+                time, process->id, state, arrival_time, process->runtime,
+                remaining_time, process->waiting_time,
+                (time - arrival_time), // Turnaround time
+                (process->runtime > 0) ? ((float)(time - arrival_time) / process->runtime) : 0.0); /* Weighted turnaround time */
 
         if(DEBUG)
         printf(ANSI_COLOR_GREEN"[SCHEDULER] Process %d finished at time %d\n"ANSI_COLOR_RESET,
@@ -145,8 +166,8 @@ void log_process_state(PCB* process, char* state, int time)
     else if (strcmp(state, "resumed") == 0)
     {
         fprintf(log_file, "At time %d process %d %s arr %d total %d remain %d wait %d\n",
-                time, process->id, state, process->arrival_time, process->runtime,
-                process->remaining_time, process->waiting_time);
+                time, process->id, state, arrival_time, process->runtime,
+                remaining_time, process->waiting_time);
 
         if(DEBUG)
         printf(ANSI_COLOR_GREEN"[SCHEDULER] Process %d resumed at time %d\n"ANSI_COLOR_RESET,
@@ -155,8 +176,8 @@ void log_process_state(PCB* process, char* state, int time)
     else if (strcmp(state, "preempted") == 0 || strcmp(state, "blocked") == 0)
     {
         fprintf(log_file, "At time %d process %d %s arr %d total %d remain %d wait %d\n",
-                time, process->id, state, process->arrival_time, process->runtime,
-                process->remaining_time, process->waiting_time);
+                time, process->id, state, arrival_time, process->runtime,
+                remaining_time, process->waiting_time);
 
         if(DEBUG)
         printf(ANSI_COLOR_GREEN"[SCHEDULER] Process %d %s at time %d\n"ANSI_COLOR_RESET,
@@ -165,30 +186,70 @@ void log_process_state(PCB* process, char* state, int time)
     else
     {
         fprintf(log_file, "At time %d process %d %s arr %d total %d remain %d wait %d\n",
-                time, process->id, state, process->arrival_time, process->runtime,
-                process->remaining_time, process->waiting_time);
+                time, process->id, state, arrival_time, process->runtime,
+                remaining_time, process->waiting_time);
     }
 
     fflush(log_file);
 }
 
-void generate_statistics()
+// Record the memory manager's counters once per tick; polls within a tick refresh its
+// sample, so each one holds the state the tick ended with
+void sample_memory_stats(int time)
 {
-    // Return early if no finished processes
-    if (finished_processes_count == 0) return;
+    if (memory_stats == NULL)
+        return;
+    if (memory_sample_count > 0 && memory_samples[memory_sample_count - 1].time > time)
+        return;
+    if (memory_sample_count > 0 && memory_samples[memory_sample_count - 1].time == time)
+        memory_sample_count--;
 
-    // Allocate memory for tracking WTA values
-    float** wta_values = (float**)malloc(finished_processes_count * sizeof(float*));
-    if (!wta_values)
+    if (memory_sample_count == memory_sample_capacity)
     {
-        perror("Failed to allocate memory for wta_values");
-        return; // Return if allocation fails
+        int new_capacity = memory_sample_capacity ? memory_sample_capacity * 2 : INITIAL_PROCESS_CAPACITY;
+        memorySample* grown = realloc(memory_samples, sizeof(memorySample) * new_capacity);
+        if (!grown)
+        {
+            perror("Failed to grow memory_samples");
+            return;
+        }
+        memory_samples = grown;
+        memory_sample_capacity = new_capacity;
     }
 
-    for (int i = 0; i < finished_processes_count; ++i)
-    {
-        wta_values[i] = NULL;
-    }
+    memory_stats_t snapshot = *memory_stats;
+    size_t reserved = snapshot.total_bytes - snapshot.free_bytes;
+    memorySample* sample = &memory_samples[memory_sample_count++];
+    sample->time = time;
+    sample->free_bytes = snapshot.free_bytes;
+    sample->largest_free = snapshot.largest_free;
+    sample->waiting = snapshot.waiting;
+    sample->external_fragmentation = snapshot.free_bytes > 0
+        ? 1.0f - (float)snapshot.largest_free / snapshot.free_bytes : 0.0f;
+    sample->internal_fragmentation = reserved > 0 && reserved >= snapshot.requested_bytes
+        ? (float)(reserved - snapshot.requested_bytes) / reserved : 0.0f;
+}
+
+static int compare_ints(const void* a, const void* b)
+{
+    return *(const int*)a - *(const int*)b;
+}
+
+// Nearest-rank percentile of the recorded memory waits; sorts them in place
+static int memory_wait_percentile(float percentile)
+{
+    int count = admitted_processes < memory_wait_capacity ? admitted_processes : memory_wait_capacity;
+    if (count == 0)
+        return 0;
+    qsort(memory_waits, count, sizeof(int), compare_ints);
+    int rank = (int)ceilf(percentile / 100 * count);
+    return memory_waits[rank > 0 ? rank - 1 : 0];
+}
+
+void generate_statistics()
+{
+    // Return early if no finished processes
+    if (finished_processes_count == 0) return;
 
     float total_wait = 0;
     float total_wta = 0;
@@ -199,25 +260,9 @@ void generate_statistics()
     // Loop through all finished processes
     for (int i = 0; i < finished_processes_count; i++)
     {
-        // Check if the pointer is valid
-        if (finished_process_info[i] == NULL)
-        {
-            fprintf(stderr, "[SCHEDULER] Error: finished_process_info[%d] is NULL\n", i);
-            continue; // Skip this iteration
-        }
-
-        total_wait += finished_process_info[i]->waiting_time;
-        total_ta += finished_process_info[i]->ta;
-        total_wta += finished_process_info[i]->wta;
-
-        // Store WTA values (not waiting times) for standard deviation calculation
-        wta_values[i] = (float*)malloc(sizeof(float));
-        if (!wta_values[i])
-        {
-            fprintf(stderr, "[SCHEDULER] Failed to allocate memory for wta_values[%d]\n", i);
-            continue;
-        }
-        *wta_values[i] = finished_process_info[i]->wta;
+        total_wait += finished_process_info[i].waiting_time;
+        total_ta += finished_process_info[i].ta;
+        total_wta += finished_process_info[i].wta;
     }
 
     float avg_wait = total_wait / finished_processes_count;
@@ -227,12 +272,8 @@ void generate_statistics()
     float sum_squared_diff = 0;
     for (int i = 0; i < finished_processes_count; i++)
     {
-        if (wta_values[i] != NULL)
-        {
-            // Add null check
-            float diff = (*wta_values[i]) - avg_wta;
-            sum_squared_diff += diff * diff;
-        }
+        float diff = finished_process_info[i].wta - avg_wta;
+        sum_squared_diff += diff * diff;
     }
     float std_wta = sqrt(sum_squared_diff / finished_processes_count);
 
@@ -248,6 +289,75 @@ void generate_statistics()
         fprintf(perf_file, "Avg WTA = %.2f\n", avg_wta);
         fprintf(perf_file, "Avg Waiting = %.2f\n", avg_wait);
         fprintf(perf_file, "Std WTA = %.2f\n", std_wta);
+        fprintf(perf_file, "Context switches = %d\n", context_switches);
+        fprintf(perf_file, "Cache refills = %d\n", cache_refills);
+        fprintf(perf_file, "Switch overhead = %.2f ticks (%.2f%%)\n", switch_overhead,
+                total_execution_time > 0 ? (switch_overhead / total_execution_time) * 100 : 0.0);
+
+        // Admission latency and fragmentation, to compare memory policies on one trace
+        fprintf(perf_file, "Memory policy = %s\n", alloc_policy_name(memory_policy));
+        fprintf(perf_file, "Admission policy = %s\n", admission_policy_name(admission_policy));
+        if (arena_count > 0 && memory_stats != NULL)
+        {
+            fprintf(perf_file, "Arena placement = %s\n", placement_policy_name(placement_policy));
+            for (int k = 0; k < memory_stats->arena_count; k++)
+            {
+                fprintf(perf_file, "Arena %d (%s) = %zu bytes, %d placements (%d spilled over), peak use %.2f%%\n",
+                        k, alloc_policy_name(arena_specs[k].policy), memory_stats->arenas[k].total_bytes,
+                        memory_stats->arenas[k].placed, memory_stats->arenas[k].spilled,
+                        memory_stats->arenas[k].total_bytes > 0
+                            ? (float)memory_stats->arenas[k].peak_used / memory_stats->arenas[k].total_bytes * 100 : 0.0);
+            }
+        }
+        if (admitted_processes > 0)
+        {
+            fprintf(perf_file, "Avg memory wait = %.2f ticks\n", (float)total_memory_wait / admitted_processes);
+            fprintf(perf_file, "P99 memory wait = %d ticks\n", memory_wait_percentile(99));
+            fprintf(perf_file, "Max memory wait = %d ticks\n", max_memory_wait);
+        }
+        if (swapper_enabled())
+        {
+            int swap_outs, swap_ins;
+            swapper_get_counts(&swap_outs, &swap_ins);
+            fprintf(perf_file, "Swap outs = %d\n", swap_outs);
+            fprintf(perf_file, "Swap ins = %d\n", swap_ins);
+            fprintf(perf_file, "Swap stall = %d ticks\n", swap_stall_ticks);
+        }
+        if (paging_enabled())
+        {
+            paging_stats_t paging;
+            paging_get_totals(&paging);
+            fprintf(perf_file, "Page replacement = %s\n", page_policy_name(paging_policy));
+            fprintf(perf_file, "Page references = %ld\n", paging.references);
+            fprintf(perf_file, "TLB hit rate = %.2f%%\n",
+                    paging.references > 0 ? (float)paging.tlb_hits / paging.references * 100 : 0.0);
+            fprintf(perf_file, "Page fault rate = %.2f%% (%ld faults, %ld write-backs)\n",
+                    paging.references > 0 ? (float)paging.faults / paging.references * 100 : 0.0,
+                    paging.faults, paging.writebacks);
+            fprintf(perf_file, "Fault stall = %.2f ticks\n", paging.stall_ticks);
+            paging_write_report("paging.log");
+        }
+
+        // Fragmentation over the per-tick samples of the memory manager
+        if (memory_sample_count > 0)
+        {
+            float peak_external = 0, total_external = 0;
+            float peak_internal = 0, total_internal = 0;
+            for (int i = 0; i < memory_sample_count; i++)
+            {
+                memorySample* sample = &memory_samples[i];
+                total_external += sample->external_fragmentation;
+                total_internal += sample->internal_fragmentation;
+                if (sample->external_fragmentation > peak_external)
+                    peak_external = sample->external_fragmentation;
+                if (sample->internal_fragmentation > peak_internal)
+                    peak_internal = sample->internal_fragmentation;
+            }
+            fprintf(perf_file, "Peak external fragmentation = %.2f%%\n", peak_external * 100);
+            fprintf(perf_file, "Avg external fragmentation = %.2f%%\n", total_external / memory_sample_count * 100);
+            fprintf(perf_file, "Peak internal fragmentation = %.2f%%\n", peak_internal * 100);
+            fprintf(perf_file, "Avg internal fragmentation = %.2f%%\n", total_internal / memory_sample_count * 100);
+        }
         fclose(perf_file);
     }
     else
@@ -255,14 +365,25 @@ void generate_statistics()
         perror("Failed to open scheduler.perf");
     }
 
-    // Free individual wta_values allocations first
-    for (int i = 0; i < finished_processes_count; ++i)
+    // The full time series, to tell queueing for capacity from queueing for fragmentation
+    if (memory_sample_count > 0)
     {
-        if (wta_values[i] != NULL)
+        FILE* stats_file = fopen("memory_stats.log", "w");
+        if (stats_file)
         {
-            free(wta_values[i]);
+            fprintf(stats_file, "#time free_bytes largest_free external_frag internal_frag waiting\n");
+            for (int i = 0; i < memory_sample_count; i++)
+            {
+                memorySample* sample = &memory_samples[i];
+                fprintf(stats_file, "%d %zu %zu %.4f %.4f %d\n", sample->time, sample->free_bytes,
+                        sample->largest_free, sample->external_fragmentation, sample->internal_fragmentation,
+                        sample->waiting);
+            }
+            fclose(stats_file);
+        }
+        else
+        {
+            perror("Failed to open memory_stats.log");
         }
     }
-
-    free(wta_values);
 }
@@ -1,13 +1,16 @@
 #pragma once
 
+#include <stdint.h>
 #include "pcb.h"
-#include "min_heap.h"
-#include "queue.h"
+#include "index_heap.h"
+#include "index_queue.h"
 
 // Function prototypes
-int compare_processes(const void* p1, const void* p2);
-PCB* hpf(min_heap_t* ready_queue, int current_time);
-PCB* srtn(min_heap_t* ready_queue);
-PCB* rr(Queue* ready_queue, int current_time);
-void log_process_state(PCB* process, char* state, int time);
-void generate_statistics();
\ No newline at end of file
+int compare_processes(uint32_t slot1, uint32_t slot2);
+// Start the process in `slot`, already taken off its ready queue; PCB_SLOT_NONE passes through
+uint32_t hpf(uint32_t slot, int current_time);
+uint32_t srtn(uint32_t slot, int current_time);
+uint32_t rr(uint32_t slot, int current_time);
+void log_process_state(uint32_t slot, char* state, int time);
+void generate_statistics();
+void sample_memory_stats(int time);
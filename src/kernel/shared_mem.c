@@ -70,7 +70,8 @@ process_info_t read_process_info(int shm_id, int pid)
 
 int get_shared_memory(key_t key)
 {
-    int shmid = shmget(key, sizeof(process_info_t) * MAX_PROCESSES, 0666);
+    // A single handshake slot is shared by whichever process is dispatched
+    int shmid = shmget(key, sizeof(process_info_t), 0666);
     if (shmid == -1)
     {
         if (DEBUG)
@@ -89,3 +90,78 @@ void cleanup_shared_memory(int shmid)
             printf(ANSI_COLOR_BLUE"[SHARED_MEM] Shared memory with ID %d removed\n"ANSI_COLOR_RESET, shmid);
     }
 }
+
+memory_stats_t* attach_memory_stats(key_t key)
+{
+    int shmid = shmget(key, sizeof(memory_stats_t), IPC_CREAT | 0666);
+    if (shmid == -1)
+    {
+        if (DEBUG)
+            perror("Error creating memory stats shared memory");
+        return NULL;
+    }
+
+    memory_stats_t* stats = (memory_stats_t*)shmat(shmid, NULL, 0);
+    if ((void*)stats == (void*)-1)
+    {
+        if (DEBUG)
+            perror("Error attaching memory stats shared memory");
+        return NULL;
+    }
+    return stats;
+}
+
+void detach_memory_stats(memory_stats_t* stats)
+{
+    if (stats != NULL)
+        shmdt(stats);
+}
+
+void cleanup_memory_stats(key_t key)
+{
+    int shmid = shmget(key, sizeof(memory_stats_t), 0666);
+    if (shmid != -1)
+    {
+        shmctl(shmid, IPC_RMID, NULL);
+        if (DEBUG)
+            printf(ANSI_COLOR_BLUE"[SHARED_MEM] Memory stats shared memory with ID %d removed\n"ANSI_COLOR_RESET, shmid);
+    }
+}
+
+swap_table_t* attach_swap_table(key_t key, int capacity)
+{
+    size_t size = sizeof(swap_table_t) + sizeof(swap_entry_t) * capacity;
+    int shmid = shmget(key, size, IPC_CREAT | 0666);
+    if (shmid == -1)
+    {
+        perror("Error creating swap table shared memory");
+        return NULL;
+    }
+
+    swap_table_t* table = (swap_table_t*)shmat(shmid, NULL, 0);
+    if ((void*)table == (void*)-1)
+    {
+        perror("Error attaching swap table shared memory");
+        return NULL;
+    }
+    memset(table, 0, size);
+    table->capacity = capacity;
+    return table;
+}
+
+void detach_swap_table(swap_table_t* table)
+{
+    if (table != NULL)
+        shmdt(table);
+}
+
+void cleanup_swap_table(key_t key)
+{
+    int shmid = shmget(key, 0, 0666);
+    if (shmid != -1)
+    {
+        shmctl(shmid, IPC_RMID, NULL);
+        if (DEBUG)
+            printf(ANSI_COLOR_BLUE"[SHARED_MEM] Swap table shared memory with ID %d removed\n"ANSI_COLOR_RESET, shmid);
+    }
+}
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <stddef.h>
 #include <sys/types.h>
+#include "arena_limits.h"
 
 typedef struct
 {
@@ -10,11 +12,65 @@ typedef struct
     int current_clk; // Handshake: scheduler writes current clock here
 } process_info_t;
 
+// Memory manager counters, kept current by the process generator and sampled by the scheduler
+typedef struct
+{
+    size_t total_bytes;     // Arena size
+    size_t free_bytes;      // Bytes held by free buddy blocks
+    size_t largest_free;    // Largest block an allocation could get right now
+    size_t requested_bytes; // Sum of the sizes live processes asked for
+    int allocations;        // Live allocations
+    int waiting;            // Processes waiting for memory
+    int arena_count;        // 1 unless memory is split into arenas
+    struct
+    {
+        size_t total_bytes;
+        size_t free_bytes;
+        size_t peak_used;   // Most bytes reserved at once
+        int placed;         // Allocations placed in this arena
+        int spilled;        // ... that the placement policy meant for another arena
+    } arenas[MAX_ARENAS];
+} memory_stats_t;
+
+// Residency of each process under the swapper, indexed by process ID. The scheduler and
+// the process generator move entries between states with atomic compare-and-swap
+typedef struct
+{
+    int state;              // One of the SWAP_* states below
+    int last_run;           // Tick the process last left the CPU (LRU order)
+    int ready_at;           // Tick its swap-in transfer completes
+    size_t size;            // Bytes it holds while resident
+} swap_entry_t;
+
+typedef struct
+{
+    int capacity;           // Entries, one per process ID
+    int swap_outs;
+    int swap_ins;
+    swap_entry_t entries[];
+} swap_table_t;
+
+#define SWAP_NONE 0         // Not admitted yet
+#define SWAP_READY 1        // Resident and in a ready queue, so it may be evicted
+#define SWAP_RUNNING 2      // Dispatched, or finished
+#define SWAP_OUT 3          // On the swap device
+#define SWAP_REQUESTED 4    // On the swap device and picked for dispatch
+#define SWAP_IN 5           // Back in memory once ready_at is reached
+
 int create_shared_memory(key_t key);
 int get_shared_memory(key_t key);
 void cleanup_shared_memory(int shmid);
 void write_process_info(int shm_id, int pid, int time_to_run, int status, int current_clk);
 process_info_t read_process_info(int shm_id, int pid);
 
+memory_stats_t* attach_memory_stats(key_t key);
+void detach_memory_stats(memory_stats_t* stats);
+void cleanup_memory_stats(key_t key);
+
+swap_table_t* attach_swap_table(key_t key, int capacity);
+void detach_swap_table(swap_table_t* table);
+void cleanup_swap_table(key_t key);
+
 #define SHM_KEY 400
-#define MAX_PROCESSES 100
+#define MEMORY_STATS_SHM_KEY 401
+#define SWAP_TABLE_SHM_KEY 402
@@ -0,0 +1,200 @@
+#include "swapper.h"
+#include <stdio.h>
+#include "clk.h"
+#include "colors.h"
+#include "memory_manager.h"
+#include "shared_mem.h"
+
+/*
+ * Swapping:
+    * 1. Every admitted process has an entry in a swap table shared by the scheduler and
+    *    the process generator. The scheduler marks it READY while it waits in a ready
+    *    queue and RUNNING while it is dispatched; only READY processes may be evicted.
+    * 2. When the next waiting process does not fit, the generator evicts READY processes,
+    *    by LRU or largest first, until it does. Eviction wins the entry with a
+    *    compare-and-swap READY -> OUT, so the scheduler can never dispatch a process
+    *    whose memory is being taken.
+    * 3. Dispatching a process that is OUT asks for it back (REQUESTED) and stalls the CPU.
+    *    The generator serves requests before admissions, evicting others if it must,
+    *    and marks the process IN with the tick its transfer completes.
+    * 4. The swap device moves one transfer at a time, each costing cost_per_kib ticks
+    *    per KiB. Evictions queue on it too, so a swap-in waits behind the write-backs
+    *    that made room for it.
+*/
+
+static swap_table_t* table = NULL;
+static swap_policy_t swap_policy = SWAP_POLICY_LRU;
+static float transfer_cost = 1;         // Ticks per KiB moved
+static int device_busy_until = 0;       // Generator only: when the last queued transfer ends
+
+static swap_entry_t* entry(int process_id) {
+    if (table == NULL || process_id < 0 || process_id >= table->capacity) {
+        return NULL;
+    }
+    return &table->entries[process_id];
+}
+
+// Queue a transfer of size bytes on the device; returns the tick it completes
+static int queue_transfer(size_t size, int now) {
+    float cost = size * transfer_cost / 1024;
+    int ticks = (int)cost;
+    if (ticks < cost) {
+        ticks++;
+    }
+    int start = device_busy_until > now ? device_busy_until : now;
+    device_busy_until = start + ticks;
+    return device_busy_until;
+}
+
+bool swapper_init(swap_policy_t policy, float cost_per_kib, int max_process_id) {
+    table = attach_swap_table(SWAP_TABLE_SHM_KEY, max_process_id + 1);
+    if (table == NULL) {
+        return false;
+    }
+    swap_policy = policy;
+    transfer_cost = cost_per_kib;
+    return true;
+}
+
+bool swapper_enabled() {
+    return table != NULL;
+}
+
+void swapper_destroy() {
+    if (table == NULL) {
+        return;
+    }
+    detach_swap_table(table);
+    table = NULL;
+    cleanup_swap_table(SWAP_TABLE_SHM_KEY);
+}
+
+void swapper_admit(int process_id, size_t size) {
+    swap_entry_t* e = entry(process_id);
+    if (e == NULL) {
+        return;
+    }
+    e->size = size;
+    e->last_run = get_clk();
+    __atomic_store_n(&e->state, SWAP_READY, __ATOMIC_RELEASE);
+}
+
+static int pick_victim() {
+    int victim = -1;
+    for (int id = 0; id < table->capacity; id++) {
+        swap_entry_t* e = &table->entries[id];
+        if (__atomic_load_n(&e->state, __ATOMIC_ACQUIRE) != SWAP_READY) {
+            continue;
+        }
+        if (victim == -1) {
+            victim = id;
+        } else if (swap_policy == SWAP_POLICY_LRU ? e->last_run < table->entries[victim].last_run
+                                                  : e->size > table->entries[victim].size) {
+            victim = id;
+        }
+    }
+    return victim;
+}
+
+bool swapper_make_room(size_t size) {
+    if (table == NULL) {
+        return mm_can_fit(size);
+    }
+    while (!mm_can_fit(size)) {
+        int victim = pick_victim();
+        if (victim == -1) {
+            return false;
+        }
+        swap_entry_t* e = &table->entries[victim];
+        int expected = SWAP_READY;
+        if (!__atomic_compare_exchange_n(&e->state, &expected, SWAP_OUT, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            continue;   // Dispatched meanwhile; pick again
+        }
+        mm_swap_out(victim);
+        queue_transfer(e->size, get_clk());
+        table->swap_outs++;
+        if (DEBUG) {
+            printf(ANSI_COLOR_YELLOW "[SWAPPER] Swapped out process ID %d (%zu bytes) to make room for %zu bytes\n"
+                ANSI_COLOR_RESET, victim, e->size, size);
+        }
+    }
+    return true;
+}
+
+void swapper_service(int now) {
+    if (table == NULL) {
+        return;
+    }
+    for (int id = 0; id < table->capacity; id++) {
+        swap_entry_t* e = &table->entries[id];
+        if (__atomic_load_n(&e->state, __ATOMIC_ACQUIRE) != SWAP_REQUESTED) {
+            continue;
+        }
+        if (!swapper_make_room(e->size) || mm_swap_in(id, e->size) == -1) {
+            continue;   // Retried on the next tick
+        }
+        e->ready_at = queue_transfer(e->size, now);
+        table->swap_ins++;
+        __atomic_store_n(&e->state, SWAP_IN, __ATOMIC_RELEASE);
+        if (DEBUG) {
+            printf(ANSI_COLOR_YELLOW "[SWAPPER] Swapping in process ID %d (%zu bytes), ready at %d\n"
+                ANSI_COLOR_RESET, id, e->size, e->ready_at);
+        }
+    }
+}
+
+bool swapper_pending() {
+    if (table == NULL) {
+        return false;
+    }
+    for (int id = 0; id < table->capacity; id++) {
+        int state = __atomic_load_n(&table->entries[id].state, __ATOMIC_ACQUIRE);
+        if (state == SWAP_OUT || state == SWAP_REQUESTED) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool swapper_claim(int process_id) {
+    swap_entry_t* e = entry(process_id);
+    if (e == NULL) {
+        return true;
+    }
+    int expected = SWAP_READY;
+    if (__atomic_compare_exchange_n(&e->state, &expected, SWAP_RUNNING, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return true;
+    }
+    if (expected == SWAP_OUT) {
+        // Only the scheduler moves an entry out of OUT
+        __atomic_store_n(&e->state, SWAP_REQUESTED, __ATOMIC_RELEASE);
+        return false;
+    }
+    return expected != SWAP_REQUESTED && expected != SWAP_IN;
+}
+
+bool swapper_arrived(int process_id, int now) {
+    swap_entry_t* e = entry(process_id);
+    if (e == NULL) {
+        return true;
+    }
+    if (__atomic_load_n(&e->state, __ATOMIC_ACQUIRE) != SWAP_IN || now < e->ready_at) {
+        return false;
+    }
+    __atomic_store_n(&e->state, SWAP_RUNNING, __ATOMIC_RELEASE);
+    return true;
+}
+
+void swapper_release(int process_id, int now) {
+    swap_entry_t* e = entry(process_id);
+    if (e == NULL) {
+        return;
+    }
+    e->last_run = now;
+    __atomic_store_n(&e->state, SWAP_READY, __ATOMIC_RELEASE);
+}
+
+void swapper_get_counts(int* swap_outs, int* swap_ins) {
+    *swap_outs = table ? table->swap_outs : 0;
+    *swap_ins = table ? table->swap_ins : 0;
+}
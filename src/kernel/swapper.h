@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef enum {
+    SWAP_POLICY_LRU,        // Evict the ready process that left the CPU longest ago
+    SWAP_POLICY_LARGEST,    // Evict the largest ready process
+} swap_policy_t;
+
+// Set up the shared swap table before forking; without it every call below is a no-op
+bool swapper_init(swap_policy_t policy, float cost_per_kib, int max_process_id);
+bool swapper_enabled();
+void swapper_destroy();                         // Detach, and remove the table
+
+// Process generator side
+void swapper_admit(int process_id, size_t size);
+bool swapper_make_room(size_t size);            // Evict ready processes until size fits
+void swapper_service(int now);                  // Bring back the processes the scheduler asked for
+bool swapper_pending();                         // Whether any process is still off memory
+
+// Scheduler side
+bool swapper_claim(int process_id);             // Before dispatch: true if resident, else asks for a swap-in
+bool swapper_arrived(int process_id, int now);  // Whether a requested swap-in has completed
+void swapper_release(int process_id, int now);  // The process went back to a ready queue
+void swapper_get_counts(int* swap_outs, int* swap_ins);
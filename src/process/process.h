@@ -5,7 +5,6 @@
 
 // Add shared memory key definition
 #define SHM_KEY 400
-#define MAX_PROCESSES 100
 
 void sigIntHandler(int signum);
 void sigStpHandler(int signum);
@@ -0,0 +1,290 @@
+/*
+ * Multi-threaded stress run for the concurrent buddy allocator.
+ *
+ * Usage: buddy_stress [operations per thread]
+ * For 1, 2, 4, 8, 16 and 32 threads, every thread keeps up to LIVE_BLOCKS blocks in a
+ * 64 MiB arena with 64 byte min blocks, freeing or allocating a random slot each step;
+ * one request in MULTI_SHARD_ODDS asks for two whole shards. Each min block a thread
+ * gets is claimed in a shadow owner map, so overlapping allocations are caught as they
+ * happen. buddy_check runs after every phase: once with the blocks still live, and
+ * again after the threads have drained them, when the arena must be entirely free.
+ * A single-shard buddy_new run gives the lock-free baseline.
+ */
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "buddy.h"
+
+#define ARENA_SIZE (64u << 20)
+#define MIN_BLOCK 64
+#define LIVE_BLOCKS 512
+#define MULTI_SHARD_ODDS 4096
+#define MAX_THREADS 32
+#define DEFAULT_OPERATIONS 200000
+
+typedef struct stress_run
+{
+    struct buddy* memory;
+    size_t shard_size;          // 0 for a single shard: no multi-shard requests
+    long operations;
+    int* owners;                // Owning thread + 1 of every min block, 0 while free
+    volatile int failed;
+} stress_run_t;
+
+typedef struct stress_thread
+{
+    stress_run_t* run;
+    int id;
+    uint32_t seed;
+    long offsets[LIVE_BLOCKS];
+    size_t sizes[LIVE_BLOCKS];
+    long allocated;
+    long rejected;
+} stress_thread_t;
+
+static uint32_t next_random(uint32_t* state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// Mostly small blocks, the occasional large one
+static size_t random_size(stress_thread_t* thread)
+{
+    uint32_t r = next_random(&thread->seed);
+    if (thread->run->shard_size && r % MULTI_SHARD_ODDS == 0)
+    {
+        return thread->run->shard_size * 2;
+    }
+    size_t size = MIN_BLOCK << (r >> 8) % 7;
+    return size - (r & 0xff) % (size / 2);
+}
+
+// Take (or release) every min block of an allocation in the shadow map
+static int claim(stress_thread_t* thread, long offset, size_t size, int from, int to)
+{
+    stress_run_t* run = thread->run;
+    for (size_t k = (size_t)offset / MIN_BLOCK; k < ((size_t)offset + size + MIN_BLOCK - 1) / MIN_BLOCK; k++)
+    {
+        int expected = from;
+        if (!__atomic_compare_exchange_n(&run->owners[k], &expected, to, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            fprintf(stderr, "Thread %d: min block %zu of [%ld, +%zu) is owned by thread %d\n",
+                    thread->id, k, offset, size, expected - 1);
+            run->failed = 1;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void release_slot(stress_thread_t* thread, int slot)
+{
+    long offset = thread->offsets[slot];
+    claim(thread, offset, thread->sizes[slot], thread->id + 1, 0);
+    if (buddy_free(thread->run->memory, offset) != 0)
+    {
+        fprintf(stderr, "Thread %d: freeing %ld was rejected\n", thread->id, offset);
+        thread->run->failed = 1;
+    }
+    thread->offsets[slot] = -1;
+}
+
+static void* churn(void* arg)
+{
+    stress_thread_t* thread = arg;
+    stress_run_t* run = thread->run;
+    for (long i = 0; i < run->operations && !run->failed; i++)
+    {
+        int slot = next_random(&thread->seed) % LIVE_BLOCKS;
+        if (thread->offsets[slot] != -1)
+        {
+            release_slot(thread, slot);
+            continue;
+        }
+        size_t size = random_size(thread);
+        long offset = buddy_alloc(run->memory, size);
+        if (offset == -1)
+        {
+            thread->rejected++;
+            continue;
+        }
+        thread->allocated++;
+        thread->offsets[slot] = offset;
+        thread->sizes[slot] = size;
+        claim(thread, offset, size, 0, thread->id + 1);
+    }
+    return NULL;
+}
+
+static void* drain(void* arg)
+{
+    stress_thread_t* thread = arg;
+    for (int slot = 0; slot < LIVE_BLOCKS; slot++)
+    {
+        if (thread->offsets[slot] != -1)
+        {
+            release_slot(thread, slot);
+        }
+    }
+    return NULL;
+}
+
+static double elapsed_seconds(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int run_phase(stress_thread_t threads[], int count, void* (*phase)(void*))
+{
+    pthread_t handles[MAX_THREADS];
+    for (int t = 0; t < count; t++)
+    {
+        if (pthread_create(&handles[t], NULL, phase, &threads[t]) != 0)
+        {
+            perror("pthread_create");
+            for (int k = 0; k < t; k++)
+            {
+                pthread_join(handles[k], NULL);
+            }
+            return -1;
+        }
+    }
+    for (int t = 0; t < count; t++)
+    {
+        pthread_join(handles[t], NULL);
+    }
+    return 0;
+}
+
+static int check(stress_run_t* run, const char* label, int thread_count)
+{
+    if (run->failed || buddy_check(run->memory) != 0)
+    {
+        fprintf(stderr, "%d threads: buddy is inconsistent %s\n", thread_count, label);
+        return -1;
+    }
+    return 0;
+}
+
+// One churn-and-drain round; returns -1 if any check failed
+static int stress(int thread_count, unsigned shards, long operations, int* owners)
+{
+    stress_run_t run = {
+        .memory = shards > 1 ? buddy_new_concurrent(ARENA_SIZE, MIN_BLOCK, shards) : buddy_new(ARENA_SIZE, MIN_BLOCK),
+        .shard_size = shards > 1 ? ARENA_SIZE / shards : 0,
+        .operations = operations,
+        .owners = owners,
+        .failed = 0,
+    };
+    if (!run.memory)
+    {
+        fprintf(stderr, "Could not create a buddy with %u shards\n", shards);
+        return -1;
+    }
+
+    memset(owners, 0, ARENA_SIZE / MIN_BLOCK * sizeof(int));
+    stress_thread_t* threads = calloc(thread_count, sizeof(stress_thread_t));
+    if (!threads)
+    {
+        perror("calloc");
+        buddy_destroy(run.memory);
+        return -1;
+    }
+    for (int t = 0; t < thread_count; t++)
+    {
+        threads[t].run = &run;
+        threads[t].id = t;
+        threads[t].seed = 2654435761u * (t + 1);
+        for (int slot = 0; slot < LIVE_BLOCKS; slot++)
+        {
+            threads[t].offsets[slot] = -1;
+        }
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int result = run_phase(threads, thread_count, churn);
+    double seconds = elapsed_seconds(&start);
+    if (result == 0)
+    {
+        result = check(&run, "with blocks live", thread_count);
+    }
+    if (result == 0)
+    {
+        result = run_phase(threads, thread_count, drain);
+    }
+    if (result == 0)
+    {
+        result = check(&run, "after draining", thread_count);
+    }
+
+    buddy_stats_t stats;
+    buddy_get_stats(run.memory, &stats);
+    if (result == 0 && stats.free_bytes != ARENA_SIZE)
+    {
+        fprintf(stderr, "%d threads: %zu of %u bytes free after draining\n", thread_count, stats.free_bytes, ARENA_SIZE);
+        result = -1;
+    }
+
+    long allocated = 0;
+    long rejected = 0;
+    for (int t = 0; t < thread_count; t++)
+    {
+        allocated += threads[t].allocated;
+        rejected += threads[t].rejected;
+    }
+    printf("%2d threads, %2u shards: %8.2f Mops/s, %ld allocations, %ld rejected%s\n",
+           thread_count, shards, thread_count * operations / seconds / 1e6, allocated, rejected,
+           result == 0 ? "" : " (FAILED)");
+
+    free(threads);
+    buddy_destroy(run.memory);
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    long operations = argc > 1 ? atol(argv[1]) : DEFAULT_OPERATIONS;
+    if (operations <= 0)
+    {
+        fprintf(stderr, "Usage: %s [operations per thread]\n", argv[0]);
+        return 1;
+    }
+    int* owners = calloc(ARENA_SIZE / MIN_BLOCK, sizeof(int));
+    if (!owners)
+    {
+        perror("calloc");
+        return 1;
+    }
+
+    int failures = 0;
+    if (stress(1, 1, operations, owners) != 0)
+    {
+        failures++;
+    }
+    for (int thread_count = 1; thread_count <= MAX_THREADS; thread_count *= 2)
+    {
+        if (stress(thread_count, MAX_THREADS, operations, owners) != 0)
+        {
+            failures++;
+        }
+    }
+
+    free(owners);
+    if (failures)
+    {
+        fprintf(stderr, "%d runs failed\n", failures);
+        return 1;
+    }
+    printf("All runs consistent\n");
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Renders the binary memory event log (memory.bin) in the memory.log text format.
+ *
+ * Usage: memlog [memory.bin [memory.log]]
+ * The output goes to stdout unless a second file is given.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memory_log.h"
+
+#define READ_BATCH 4096
+
+static void render_event(FILE* out, const memory_event_t* event)
+{
+    long start = event->offset;
+    long end = start + event->size - 1;
+    switch (event->op)
+    {
+    case MEMORY_EVENT_ALLOC:
+        fprintf(out, "At time %d allocated %u bytes for process %d from %ld to %ld (internal fragmentation %zu bytes)\n",
+                event->tick, event->size, event->id, start, end, (size_t)(event->reserved - event->size));
+        break;
+    case MEMORY_EVENT_FREE:
+        fprintf(out, "At time %d freed %u bytes from process %d from %ld to %ld\n",
+                event->tick, event->size, event->id, start, end);
+        break;
+    case MEMORY_EVENT_GROW:
+        fprintf(out, "At time %d grew memory from %zu to %zu bytes\n",
+                event->tick, (size_t)event->offset, (size_t)event->reserved);
+        break;
+    case MEMORY_EVENT_SWAP_OUT:
+    case MEMORY_EVENT_SWAP_IN:
+        fprintf(out, "At time %d swapped %s %u bytes of process %d from %ld to %ld\n",
+                event->tick, event->op == MEMORY_EVENT_SWAP_IN ? "in" : "out", event->size, event->id, start, end);
+        break;
+    default:
+        fprintf(stderr, "Skipping event with unknown operation %u at time %d\n", event->op, event->tick);
+        break;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* input_name = argc > 1 ? argv[1] : MEMORY_LOG_FILE;
+    FILE* in = fopen(input_name, "rb");
+    if (!in)
+    {
+        perror(input_name);
+        return 1;
+    }
+
+    memory_log_header_t header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || memcmp(header.magic, MEMORY_LOG_MAGIC, sizeof(header.magic)) != 0)
+    {
+        fprintf(stderr, "%s is not a memory event log\n", input_name);
+        fclose(in);
+        return 1;
+    }
+    if (header.version != MEMORY_LOG_VERSION || header.record_size != sizeof(memory_event_t))
+    {
+        fprintf(stderr, "%s has version %u with %u-byte records; expected version %d with %zu-byte records\n",
+                input_name, header.version, header.record_size, MEMORY_LOG_VERSION, sizeof(memory_event_t));
+        fclose(in);
+        return 1;
+    }
+
+    FILE* out = stdout;
+    if (argc > 2 && !(out = fopen(argv[2], "w")))
+    {
+        perror(argv[2]);
+        fclose(in);
+        return 1;
+    }
+
+    fprintf(out, "#At time x allocated y bytes for process z from i to j (internal fragmentation k bytes)\n");
+    memory_event_t* events = malloc(sizeof(memory_event_t) * READ_BATCH);
+    if (!events)
+    {
+        perror("Failed to allocate read buffer");
+        fclose(in);
+        if (out != stdout)
+            fclose(out);
+        return 1;
+    }
+    size_t count;
+    while ((count = fread(events, sizeof(memory_event_t), READ_BATCH, in)) > 0)
+    {
+        for (size_t i = 0; i < count; i++)
+            render_event(out, &events[i]);
+    }
+
+    free(events);
+    fclose(in);
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
@@ -0,0 +1,214 @@
+/*
+ * Scaling run for the scheduler's process tables: the PCB pool and the ready queues.
+ *
+ * Usage: pcb_scale [processes]
+ * Starting from INITIAL_PROCESS_CAPACITY, admits every process into the pool and both
+ * ready queues at once, then drains them: the heap must return processes in SRTN order
+ * and the queue in arrival order, and every slot must be handed out exactly once. A
+ * second round churns a fixed working set to show retired slots are reused without the
+ * pool growing. The simulator itself ticks once a second and forks a real process per
+ * job, so this is how the tables are taken to a million processes and beyond.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+#include "headers.h"
+#include "index_heap.h"
+#include "index_queue.h"
+#include "pcb_pool.h"
+
+#define DEFAULT_PROCESSES 1000000
+#define CHURN_WORKING_SET 1000
+
+static pcb_pool_t* pool = NULL;
+
+// SRTN order: least remaining time first, then earliest arrival
+static int compare_remaining(uint32_t slot1, uint32_t slot2)
+{
+    if (pool->remaining_time[slot1] != pool->remaining_time[slot2])
+    {
+        return pool->remaining_time[slot1] - pool->remaining_time[slot2];
+    }
+    return pool->arrival_time[slot1] - pool->arrival_time[slot2];
+}
+
+static double elapsed_seconds(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static uint32_t admit(int id)
+{
+    PCB pcb = {
+        1, id, id,
+        id, 1 + (id * 7919) % 1000,
+        1 + (id * 7919) % 1000, id % 11, 0, -1, -1, -1, -1, -1,
+        -1,
+        READY,
+    };
+    uint32_t slot = pcb_pool_alloc(pool);
+    if (slot != PCB_SLOT_NONE)
+    {
+        pcb_pool_store(pool, slot, &pcb);
+    }
+    return slot;
+}
+
+// Admit `count` processes into both queues and drain them; returns -1 on any mismatch
+static int fill_and_drain(int count, index_heap_t* heap, index_queue_t* queue)
+{
+    uint8_t* seen = calloc(count, 1);
+    if (!seen)
+    {
+        perror("calloc");
+        return -1;
+    }
+
+    for (int id = 0; id < count; id++)
+    {
+        uint32_t slot = admit(id);
+        if (slot == PCB_SLOT_NONE)
+        {
+            fprintf(stderr, "Pool refused process %d\n", id);
+            free(seen);
+            return -1;
+        }
+        index_heap_insert(heap, slot);
+        index_queue_push(queue, slot);
+    }
+
+    int result = 0;
+    for (int id = 0; id < count && result == 0; id++)
+    {
+        uint32_t slot = index_queue_pop(queue);
+        if (pool->cold[slot].id != id)
+        {
+            fprintf(stderr, "Queue returned process %d in place of %d\n", pool->cold[slot].id, id);
+            result = -1;
+        }
+    }
+
+    uint32_t previous = PCB_SLOT_NONE;
+    for (int i = 0; i < count && result == 0; i++)
+    {
+        uint32_t slot = index_heap_extract_min(heap);
+        int id = pool->cold[slot].id;
+        if (id < 0 || id >= count || seen[id])
+        {
+            fprintf(stderr, "Heap returned process %d twice or out of range\n", id);
+            result = -1;
+        }
+        else if (previous != PCB_SLOT_NONE && compare_remaining(previous, slot) > 0)
+        {
+            fprintf(stderr, "Heap returned process %d out of order\n", id);
+            result = -1;
+        }
+        else
+        {
+            seen[id] = 1;
+        }
+        if (previous != PCB_SLOT_NONE)
+        {
+            pcb_pool_free(pool, previous);
+        }
+        previous = slot;
+    }
+    if (previous != PCB_SLOT_NONE)
+    {
+        pcb_pool_free(pool, previous);
+    }
+
+    if (result == 0 && (!index_heap_is_empty(heap) || !index_queue_is_empty(queue) || pool->used != 0))
+    {
+        fprintf(stderr, "%u slots still in use after draining\n", pool->used);
+        result = -1;
+    }
+    free(seen);
+    return result;
+}
+
+// Retire the oldest and admit a new process `count` times over a fixed working set
+static int churn(int count, index_queue_t* queue)
+{
+    uint32_t capacity = 0;
+    for (int id = 0; id < count; id++)
+    {
+        if (id >= CHURN_WORKING_SET)
+        {
+            pcb_pool_free(pool, index_queue_pop(queue));
+        }
+        uint32_t slot = admit(id);
+        if (slot == PCB_SLOT_NONE)
+        {
+            fprintf(stderr, "Pool refused process %d\n", id);
+            return -1;
+        }
+        index_queue_push(queue, slot);
+        if (id == CHURN_WORKING_SET)
+        {
+            capacity = pool->capacity;
+        }
+    }
+    while (!index_queue_is_empty(queue))
+    {
+        pcb_pool_free(pool, index_queue_pop(queue));
+    }
+    if (capacity && pool->capacity != capacity)
+    {
+        fprintf(stderr, "Pool grew from %u to %u slots with a steady working set\n", capacity, pool->capacity);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    int count = argc > 1 ? atoi(argv[1]) : DEFAULT_PROCESSES;
+    if (count <= 0)
+    {
+        fprintf(stderr, "Usage: %s [processes]\n", argv[0]);
+        return 1;
+    }
+
+    pool = pcb_pool_create(INITIAL_PROCESS_CAPACITY);
+    index_heap_t* heap = create_index_heap(INITIAL_PROCESS_CAPACITY, compare_remaining);
+    index_queue_t* queue = create_index_queue(INITIAL_PROCESS_CAPACITY);
+    if (!pool || !heap || !queue)
+    {
+        perror("Failed to create the process tables");
+        return 1;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int result = fill_and_drain(count, heap, queue);
+    double seconds = elapsed_seconds(&start);
+    printf("%d processes live at once: %.2f s, pool grew to %u slots\n", count, seconds, pool->capacity);
+
+    if (result == 0)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        result = churn(count, queue);
+        printf("%d processes through %d live: %.2f s\n", count, CHURN_WORKING_SET, elapsed_seconds(&start));
+    }
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        printf("Peak resident set: %ld MiB\n", usage.ru_maxrss / 1024);
+    }
+
+    destroy_index_queue(queue);
+    destroy_index_heap(heap);
+    pcb_pool_destroy(pool);
+    if (result != 0)
+    {
+        return 1;
+    }
+    printf("All processes accounted for\n");
+    return 0;
+}